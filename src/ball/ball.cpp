@@ -4,87 +4,96 @@
 #include "states.h"
 #include "../game.h"
 
-/*
- * In this game two players take turns putting balls on a board
- * the first person to reach 9 or more balls wins.
- * If the player did not put a ball their last turn, they can
- * instead put 3 balls.
- * This is used as a simple example to test the tree-search.
- */
-
-void deleteState(Gamestate* statep)
+namespace ball
 {
-	delete statep;
-}
-
-void deleteAction(Action* actionp)
-{
-	delete actionp;
-}
+	/*
+	 * In this game two players take turns putting balls on a board
+	 * the first person to reach 9 or more balls wins.
+	 * If the player did not put a ball their last turn, they can
+	 * instead put 3 balls.
+	 * This is used as a simple example to test the tree-search.
+	 */
 
-void genChildren(Gamestate const* statep, std::vector<Gamestate*>& gamestates, std::vector<Action*>& actions) {
-	// Game has ended
-	if (statep->white >= 9) {
-		return;
-	} else if (statep->black >= 9) {
-		return;
+	namespace
+	{
+		// Gamestates before each action of the in-place interface, per thread and indexed by ply
+		thread_local std::vector<Gamestate> undoStack;
 	}
 
+	void Ball::genActions(Gamestate const* statep, std::vector<Action>& actions) {
+		// Game has ended
+		if (statep->white >= 9) {
+			return;
+		} else if (statep->black >= 9) {
+			return;
+		}
 
-	// Player does put
-	actions.push_back(new Action{ true });
-	Gamestate* state2 = new Gamestate{*statep};
-	gamestates.push_back(state2);
+		actions.push_back({ true });
+		actions.push_back({ false });
+	}
 
-	// Update player score
-	if (state2->whitetoMove) {
-		if (state2->timeSinceWhite >= 1) {
-			state2->white += 3;
-			state2->timeSinceWhite = 0;
-		} else {
-			state2->white++;
-		}
-	} else {
-		if (state2->timeSinceBlack >= 1) {
-			state2->black += 3;
-			state2->timeSinceBlack = 0;
+	void Ball::makeMove(Gamestate& state, Action const* actionp, unsigned int ply) {
+		if (ply >= undoStack.size())
+			undoStack.resize(ply + 1);
+		undoStack[ply] = state;
+
+		if (actionp->put) {
+			// Update player score
+			if (state.whitetoMove) {
+				if (state.timeSinceWhite >= 1) {
+					state.white += 3;
+					state.timeSinceWhite = 0;
+				} else {
+					state.white++;
+				}
+			} else {
+				if (state.timeSinceBlack >= 1) {
+					state.black += 3;
+					state.timeSinceBlack = 0;
+				} else {
+					state.black++;
+				}
+			}
 		} else {
-			state2->black++;
+			// Update time since player last put
+			if (state.whitetoMove) {
+				state.timeSinceWhite++;
+			} else {
+				state.timeSinceBlack++;
+			}
 		}
+		state.whitetoMove = !state.whitetoMove;
 	}
-	state2->whitetoMove = !state2->whitetoMove;
-
-	// Player does not put
-	actions.push_back(new Action{ false });
-	Gamestate* state1 = new Gamestate{*statep};
-	gamestates.push_back(state1);
 
-	// Update time since player last put
-	if (state1->whitetoMove) {
-		state1->timeSinceWhite++;
-	} else {
-		state1->timeSinceBlack++;
+	void Ball::unmakeMove(Gamestate& state, Action const*, unsigned int ply) {
+		state = undoStack[ply];
 	}
-	state1->whitetoMove = !state1->whitetoMove;
 
-	return;
-}
+	float Ball::evaluation(Gamestate const* statep) {
+		if (statep->white >= 9) {
+			return 100;
+		} else if (statep->black >= 9) {
+			return -100;
+		}
+		return static_cast<float>(static_cast<int>(statep->white) - static_cast<int>(statep->black));
+	}
 
-float evaluation(Gamestate const* statep) {
-	if (statep->white >= 9) {
-		return 100;
-	} else if (statep->black >= 9) {
-		return -100;
+	uint64_t Ball::hashState(Gamestate const* statep) {
+		// The counters never get large enough to overlap
+		return static_cast<uint64_t>(statep->whitetoMove) |
+			static_cast<uint64_t>(statep->white) << 1 |
+			static_cast<uint64_t>(statep->timeSinceWhite) << 16 |
+			static_cast<uint64_t>(statep->black) << 32 |
+			static_cast<uint64_t>(statep->timeSinceBlack) << 48;
 	}
-	return static_cast<float>(static_cast<int>(statep->white) - static_cast<int>(statep->black));
-}
 
-std::string Action::toString() {
-	return put ? "put" : "no put";
-}
+	std::string Action::toString() {
+		return put ? "put" : "no put";
+	}
 
-std::string Gamestate::toString() {
-	return std::string("To move: ") + (whitetoMove ? "white\n" : "black\n") +
-		"\twhite: " + std::to_string(white) + ":" + std::to_string(timeSinceWhite) + "\n" +
-		"\tblack: " + std::to_string(black) + ":" + std::to_string(timeSinceBlack);
+	std::string Gamestate::toString() {
+		return std::string("To move: ") + (whitetoMove ? "white\n" : "black\n") +
+			"\twhite: " + std::to_string(white) + ":" + std::to_string(timeSinceWhite) + "\n" +
+			"\tblack: " + std::to_string(black) + ":" + std::to_string(timeSinceBlack);
+	}
 }
@@ -5,6 +5,7 @@
 #include "../trees.h"
 #include "../game.h"
 
+using namespace ball;
 
 int main() {
 	Gamestate* sp = new Gamestate{ true, 0, 0, 0, 0 };
@@ -12,7 +13,7 @@ int main() {
 
 	unsigned int depth = 15;
 
-	Evaluation e = bestAction(sp, depth);
+	Evaluation<Ball> e = bestAction<Ball>(sp, depth);
 	std::cout <<
 		"Best action is:\t" << e.action->toString() << std::endl <<
 		"Evaluation:\t" << e.evaluation << std::endl;
@@ -1,24 +1,63 @@
-#ifndef STATES_H_INCLUDED
-#define STATES_H_INCLUDED
+#ifndef BALL_STATES_H_INCLUDED
+#define BALL_STATES_H_INCLUDED
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
-struct Action
+#include "../game.h"
+
+namespace ball
 {
-	bool put; // Whether or not to put
+	struct Action
+	{
+		bool put; // Whether or not to put
 
-	std::string toString();
-};
+		std::string toString();
+	};
 
-struct Gamestate
-{
-	bool whitetoMove;
-	unsigned int white;
-	unsigned int timeSinceWhite;
-	unsigned int black;
-	unsigned int timeSinceBlack;
-
-	std::string toString();
-};
+	struct Gamestate
+	{
+		bool whitetoMove;
+		unsigned int white;
+		unsigned int timeSinceWhite;
+		unsigned int black;
+		unsigned int timeSinceBlack;
+
+		std::string toString();
+	};
+
+	// Game policy for the search, see game.h
+	struct Ball : ActionStack<Ball, Gamestate, Action>
+	{
+		using State = Gamestate;
+		using Action = ball::Action;
+
+		static bool whiteToMove(State const* statep) { return statep->whitetoMove; }
+
+		static void deleteState(State* statep) { delete statep; }
+		static void deleteAction(Action* actionp) { delete actionp; }
+
+		static void genActions(State const* statep, std::vector<Action>& actions);
+
+		static void makeMove(State& state, Action const* actionp, unsigned int ply);
+		static void unmakeMove(State& state, Action const* actionp, unsigned int ply);
+		static bool makeNullMove(State&, unsigned int)
+		{
+			// Not putting is already a regular action
+			return false;
+		}
+		static void unmakeNullMove(State&, unsigned int) {}
+
+		static float evaluation(State const* statep);
+		static uint64_t hashState(State const* statep);
+		static uint16_t actionKey(Action const* actionp) { return actionp->put; }
+		static bool isQuiet(State const*, Action const*)
+		{
+			// Nothing is ever captured
+			return true;
+		}
+	};
+}
 
 #endif
@@ -1,80 +1,65 @@
-#ifndef ATTACKS_H_INCLUDED
-#define ATTACKS_H_INCLUDED
+#ifndef CHESS_ATTACKS_H_INCLUDED
+#define CHESS_ATTACKS_H_INCLUDED
 
 #include "pieces.h"
 #include "board.h"
+#include "bitboard.h"
 
-#include <array>
-#include <map>
-#include <memory>
-
-enum class AttackStatus
+namespace chess
 {
-	CLEAR,
-	ATTACKED,
-	PINNED
-};
+	// Checks and pins on the king of the player to move
+	// Fixed size, so finding them doesn't allocate
+	struct AttackInfo
+	{
+		unsigned int kingSquare;
+
+		// Opponent pieces giving check
+		Bitboard checkers;
+
+		// Squares other pieces than the king must move to, to not leave the king
+		// in check: every square when not in check, the checker and the squares
+		// between it and the king in single check, and none in double check
+		Bitboard evasionMask;
+
+		// Pieces of the player to move that are pinned to their king
+		// They can only move along the line through the king
+		Bitboard pinned;
 
-const std::array<Delta, 8> knightMoves = {
-	Delta{ 2,  1},
-	Delta{ 1,  2},
-	Delta{-1,  2},
-	Delta{-2,  1},
-	Delta{-2, -1},
-	Delta{-1, -2},
-	Delta{ 1, -2},
-	Delta{ 2, -1}
-};
+		// Squares attacked by the opponent. Sliders see through the king, so it
+		// can't step back along the line of a check
+		Bitboard attacked;
 
-const std::map<Delta, unsigned int> kingMoveOrder {
-	{{ 1,  0}, 0},
-	{{ 1,  1}, 1},
-	{{ 0,  1}, 2},
-	{{-1,  1}, 3},
-	{{-1,  0}, 4},
-	{{-1, -1}, 5},
-	{{ 0, -1}, 6},
-	{{ 1, -1}, 7},
-	// Castling
-	{{ 0, -2}, 8},
-	{{ 0,  2}, 9}
-};
+		inline unsigned int amtChecks() const { return popcount(checkers); }
 
-AttackStatus checkAttack(
-	const Board& b,
-	const Coordinate& kingPos,
-	const Coordinate& attackerPos,
-	Color opponent,
-	Coordinate& pinnedPos,
-	std::array<bool, 10>& attackedSquares
-);
+		// Squares the piece on `square` can move to without leaving the king in check
+		// Not for the king itself, or for en passant, see isLegalPassant
+		inline Bitboard legalTargets(unsigned int square) const
+		{
+			if (pinned & squareBB(square))
+				return evasionMask & lineThrough[kingSquare][square];
+			return evasionMask;
+		}
+	};
 
-void checkGuarded(
-	const Board& b,
-	const Coordinate& target,
-	const Coordinate& kingPos,
-	const Coordinate& attackerPos,
-	std::array<bool, 10>& attackedSquares
-);
+	// Find the checks and pins on the king of `toMove`, and return the amount of checks
+	unsigned int getAttacks(const Board& board, Color toMove, AttackInfo& info);
 
-unsigned int getAttacks(
-	// Parameters
-	const Board& board,
-	const Coordinate& kingPos,
-	Color toMove,
-	// Output
-	// Bool array for the squares around the king
-	// Ordered according to kingMoveOrder
-	std::array<bool, 10>& attackedSquares,
+	// Find only the checks on the king of `toMove`, and return the amount of checks
+	// Nothing is marked pinned or attacked, for pseudo-legal move generation
+	unsigned int getChecks(const Board& board, Color toMove, AttackInfo& info);
 
-	// If there is an associated object, all valid moves must kill the piece at that pos
-	std::unique_ptr<Coordinate>& mustKill,
+	// Pieces of both colors attacking `square`, with the pieces on `occupied` blocking sliders
+	Bitboard attackersTo(const Board& board, unsigned int square, Bitboard occupied);
 
-	// If there is an associated object, all valid moves must move to that line
-	std::unique_ptr<Line>& mustBlock,
+	// Static exchange evaluation: material won by the capture from `from` to
+	// `to`, in pawns, when both players keep capturing on `to` with their least
+	// valuable piece as long as it gains them material. Pins are ignored
+	float see(const Board& board, unsigned int from, unsigned int to);
 
-	// Map from pinned postions to the line they are pinned on
-	std::map<Coordinate, Line>& pinnedPositions
-);
+	// Whether the pawn on `from` can capture en passant on `target` without
+	// leaving its king in check. Besides pins on the pawn, taking both pawns off
+	// the rank may uncover a check, and the captured pawn may be the checker
+	bool isLegalPassant(const Board& board, unsigned int from, unsigned int target, const AttackInfo& info);
+}
 
 #endif
@@ -0,0 +1,125 @@
+#ifndef CHESS_BITBOARD_H_INCLUDED
+#define CHESS_BITBOARD_H_INCLUDED
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace chess
+{
+	// Set of squares, the square {rank, file} is bit rank*8 + file
+	// So a1 is the lowest bit, and iterating from the lowest bit goes through
+	// the board rank by rank, like the loops over coordinates
+	typedef uint64_t Bitboard;
+
+	inline constexpr Bitboard squareBB(unsigned int square)
+	{
+		return Bitboard{1} << square;
+	}
+
+	inline unsigned int popcount(Bitboard b)
+	{
+		return __builtin_popcountll(b);
+	}
+
+	// Lowest square of a non-empty set
+	inline unsigned int lsb(Bitboard b)
+	{
+		return __builtin_ctzll(b);
+	}
+
+	// Remove the lowest square of a non-empty set and return it
+	inline unsigned int popLsb(Bitboard& b)
+	{
+		unsigned int square = lsb(b);
+		b &= b - 1;
+		return square;
+	}
+
+	// Squares reached from `square` by a single one of the (rank, file) steps
+	template <size_t N>
+	constexpr Bitboard stepAttacks(unsigned int square, const int (&steps)[N][2])
+	{
+		Bitboard attacks = 0;
+		int rank = square / 8;
+		int file = square % 8;
+		for (const auto& step : steps) {
+			int toRank = rank + step[0];
+			int toFile = file + step[1];
+			if (toRank >= 0 && toRank < 8 && toFile >= 0 && toFile < 8)
+				attacks |= squareBB(toRank * 8 + toFile);
+		}
+		return attacks;
+	}
+
+	template <size_t N>
+	constexpr std::array<Bitboard, 64> stepAttackTable(const int (&steps)[N][2])
+	{
+		std::array<Bitboard, 64> table {};
+		for (unsigned int square=0; square<64; square++)
+			table[square] = stepAttacks(square, steps);
+		return table;
+	}
+
+	constexpr int KNIGHT_STEPS[8][2] = {{2, 1}, {1, 2}, {-1, 2}, {-2, 1}, {-2, -1}, {-1, -2}, {1, -2}, {2, -1}};
+	constexpr int KING_STEPS[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+	constexpr int BLACK_PAWN_STEPS[2][2] = {{-1, -1}, {-1, 1}};
+	constexpr int WHITE_PAWN_STEPS[2][2] = {{1, -1}, {1, 1}};
+
+	// Squares attacked by a piece on the square
+	inline constexpr std::array<Bitboard, 64> knightAttacks = stepAttackTable(KNIGHT_STEPS);
+	inline constexpr std::array<Bitboard, 64> kingAttacks = stepAttackTable(KING_STEPS);
+	// Indexed by whether the pawn is white
+	inline constexpr std::array<Bitboard, 64> pawnAttacks[2] = {
+		stepAttackTable(BLACK_PAWN_STEPS),
+		stepAttackTable(WHITE_PAWN_STEPS)
+	};
+
+	// Squares reached from `from` by repeating a step towards `to`, up to `to`
+	// or the edge, or no squares when they aren't on a common line
+	constexpr Bitboard rayTowards(unsigned int from, unsigned int to, bool pastTarget)
+	{
+		int rankDelta = static_cast<int>(to / 8) - static_cast<int>(from / 8);
+		int fileDelta = static_cast<int>(to % 8) - static_cast<int>(from % 8);
+		bool straight = rankDelta == 0 || fileDelta == 0;
+		bool diagonal = rankDelta == fileDelta || rankDelta == -fileDelta;
+		if (from == to || !(straight || diagonal))
+			return 0;
+
+		int rankStep = (rankDelta > 0) - (rankDelta < 0);
+		int fileStep = (fileDelta > 0) - (fileDelta < 0);
+		Bitboard ray = 0;
+		int rank = from / 8 + rankStep;
+		int file = from % 8 + fileStep;
+		for (; rank >= 0 && rank < 8 && file >= 0 && file < 8; rank += rankStep, file += fileStep) {
+			if (!pastTarget && static_cast<unsigned int>(rank * 8 + file) == to)
+				break;
+			ray |= squareBB(rank * 8 + file);
+		}
+		return ray;
+	}
+
+	typedef std::array<std::array<Bitboard, 64>, 64> SquarePairTable;
+
+	constexpr SquarePairTable squarePairTable(bool line)
+	{
+		SquarePairTable table {};
+		for (unsigned int a=0; a<64; a++)
+			for (unsigned int b=0; b<64; b++) {
+				if (line && rayTowards(a, b, true))
+					// Both directions from `a`, and `a` itself
+					table[a][b] = rayTowards(a, b, true) | rayTowards(b, a, true);
+				else if (!line)
+					table[a][b] = rayTowards(a, b, false);
+			}
+		return table;
+	}
+
+	// Squares strictly between two squares on a common rank, file or diagonal,
+	// none otherwise
+	inline constexpr SquarePairTable squaresBetween = squarePairTable(false);
+	// The whole rank, file or diagonal through two squares, none if there is none
+	inline constexpr SquarePairTable lineThrough = squarePairTable(true);
+}
+
+#endif
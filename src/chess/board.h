@@ -1,7 +1,9 @@
-#ifndef BOARD_H_INCLUDED
-#define BOARD_H_INCLUDED
+#ifndef CHESS_BOARD_H_INCLUDED
+#define CHESS_BOARD_H_INCLUDED
 
 #include "pieces.h"
+#include "zobrist.h"
+#include "bitboard.h"
 
 #include <cmath>
 #include <string>
@@ -9,99 +11,96 @@
 #include <iostream>
 #include <cassert>
 
-struct Coordinate;
-// Alias for Coordinate
-typedef Coordinate Delta;
-
-struct Coordinate
+namespace chess
 {
-	int rank;
-	int file;
-
-	Coordinate(int rank, int file): rank{rank}, file{file} {}
-	Coordinate(std::string SAN);
-	Coordinate() = default;
-
-	inline bool isValid() const {return rank<8 && rank>=0 && file<8 && file>=0;}
+	struct Coordinate;
+	// Alias for Coordinate
+	typedef Coordinate Delta;
 
-	// Useful for deltas
-	inline int infNorm() const {return std::max(std::abs(rank), std::abs(file));}
-	inline bool isStraight() const {return (rank == 0) != (file == 0);}
-	inline bool isDiagonal() const {return rank != 0 && std::abs(rank) == std::abs(file);}
-	Delta step() const;
+	struct Coordinate
+	{
+		int rank;
+		int file;
 
-	std::string toSAN() const;
-	std::string toString() const { return toSAN(); }
+		Coordinate(int rank, int file): rank{rank}, file{file} {}
+		Coordinate(std::string SAN);
+		Coordinate() = default;
 
-	Coordinate operator +(const Coordinate& b) const;
-	Coordinate& operator +=(const Coordinate& b);
-	Coordinate operator -(const Coordinate& b) const;
-	Coordinate& operator -=(const Coordinate& b);
-	Coordinate operator -() const;
+		inline bool isValid() const {return rank<8 && rank>=0 && file<8 && file>=0;}
 
-	bool operator ==(const Coordinate& b) const;
-	bool operator !=(const Coordinate& b) const;
-};
+		// Index of the square in a Bitboard
+		inline unsigned int square() const {return rank * 8 + file;}
+		static inline Coordinate fromSquare(unsigned int square) {return {static_cast<int>(square / 8), static_cast<int>(square % 8)};}
 
-namespace std
-{
-	template<> struct less<Delta>
-	{
-		bool operator() (const Delta& lhs, const Delta& rhs) const
-		{
-			// Orders Deltas with Linf < 16
-			return (32*lhs.rank + lhs.file) < (32*rhs.rank + rhs.file);
-		}
-	};
-}
+		// Useful for deltas
+		inline int infNorm() const {return std::max(std::abs(rank), std::abs(file));}
+		inline bool isStraight() const {return (rank == 0) != (file == 0);}
+		inline bool isDiagonal() const {return rank != 0 && std::abs(rank) == std::abs(file);}
+		Delta step() const;
 
-struct Line
-{
-	// Represents a line-segment on the board
-	Coordinate start;
-	Delta step;
-	int maxSteps;
+		std::string toSAN() const;
+		std::string toString() const { return toSAN(); }
 
-	Line(Coordinate start, Coordinate end)
-		: start{start}
-	{
-		Delta delta {end-start};
-		// delta must be straight or diagonal
-		assert(delta.isDiagonal() || delta.isStraight());
+		Coordinate operator +(const Coordinate& b) const;
+		Coordinate& operator +=(const Coordinate& b);
+		Coordinate operator -(const Coordinate& b) const;
+		Coordinate& operator -=(const Coordinate& b);
+		Coordinate operator -() const;
 
-		maxSteps = delta.infNorm();
-		step = {delta.rank / maxSteps, delta.file/maxSteps};
-	}
+		bool operator ==(const Coordinate& b) const;
+		bool operator !=(const Coordinate& b) const;
+	};
 
-	bool contains(Coordinate pos) const
+	struct Board
 	{
-		// Return true if pos is on the line, including the endpoint, but not including the start
-		Delta direction = pos - start;
-		int Linf = direction.infNorm();
-		// The inf-norm of the direction-vector corresponds to the required amount
-		// of steps of a step-vector with inf-norm 1
-		if (Linf > maxSteps || Linf == 0)
-			return false;
-
-		// Scaled direction-vector matches step-vector
-		return (
-			static_cast<float>(direction.rank)/Linf == step.rank &&
-			static_cast<float>(direction.file)/Linf == step.file
-		);
-	}
-};
-
-struct Board
-{
-	uint8_t _board[64];
-
-	Piece get(Coordinate pos) const;
-	void set(Coordinate pos, Piece piece);
-	void move(Coordinate from, Coordinate to);
+		// The pieces are stored as bitboards only, so the whole gamestate fits in
+		// a cache line. Bit i of the square in _typeBits[i] is bit i of the type
+		// of the piece on it, _white has the squares of white pieces and
+		// _occupied those of all pieces
+		Bitboard _typeBits[3] {};
+		Bitboard _white = 0;
+		Bitboard _occupied = 0;
+		// Zobrist key of the pieces on the board, kept up to date by set
+		uint64_t key = 0;
+		// PSQT score in centipawns and material balance in pawns, positive for
+		// white, also kept up to date by set
+		int16_t psqt = 0;
+		int16_t material = 0;
+
+		inline Piece get(Coordinate pos) const
+		{
+			assert(pos.isValid());
+			unsigned int square = pos.square();
+			unsigned int type = (_typeBits[0] >> square & 1) |
+				(_typeBits[1] >> square & 1) << 1 |
+				(_typeBits[2] >> square & 1) << 2;
+			return type | (_white >> square & 1) << 3;
+		}
+		void set(Coordinate pos, Piece piece);
+		void move(Coordinate from, Coordinate to);
 
-	void print(Color perspective=WHITE, bool colorTerminal=false, std::ostream& stream=std::cout) const;
-};
+		inline Bitboard occupancy() const { return _occupied; }
+		inline Bitboard empty() const { return ~_occupied; }
+		inline Bitboard pieces(Color c) const { return c == WHITE ? _white : _occupied ^ _white; }
+		inline Bitboard pieces(PieceType type) const
+		{
+			// Squares where each type bit matches, folded to a few instructions
+			// when the type is known at compile time. The bits of NONE would
+			// match the empty squares, use occupancy or empty instead
+			assert(type != NONE && type != UNKNOWN);
+			return (type & 1 ? _typeBits[0] : ~_typeBits[0]) &
+				(type & 2 ? _typeBits[1] : ~_typeBits[1]) &
+				(type & 4 ? _typeBits[2] : ~_typeBits[2]);
+		}
+		inline Bitboard pieces(Color c, PieceType type) const
+		{
+			return pieces(type) & (c == WHITE ? _white : ~_white);
+		}
+		// Square of the king, boards always have one per color
+		inline unsigned int kingSquare(Color c) const { return lsb(pieces(c, KING)); }
 
-Coordinate findKing(const Board& b, Color c);
+		void print(Color perspective=WHITE, bool colorTerminal=false, std::ostream& stream=std::cout) const;
+	};
+}
 
 #endif
@@ -3,338 +3,176 @@
 #include "board.h"
 #include "states.h"
 #include "attacks.h"
+#include "magic.h"
 #include "../game.h"
 
-#include <cmath>
-#include <map>
-#include <memory>
-#include <array>
-#include <stdexcept>
-
-
-bool hasPawnMove(
-	Gamestate const* statep,
-	Color c,
-	Coordinate pos,
-	std::unique_ptr<Coordinate>& mustKill,
-	std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions
-)
+namespace chess
 {
-	int direction = pawnDirection(c);
-	Coordinate target;
-	auto pinnedElement = pinnedPositions.find(pos);
-
-	for (int side=-1; side<=1; side+=2) {
-		target = pos + Coordinate{direction, side};
-		if (!target.isValid())
-			continue;
+	namespace
+	{
+		// Attack analysis of the last gamestate analysed by this thread
+		struct Analysis
+		{
+			bool valid = false;
+			uint64_t key;
+			AttackInfo info;
+			// Whether the gamestate is known to have no legal moves
+			bool noMoves;
+		};
+
+		thread_local Analysis analysis;
+
+		Analysis& analyse(Gamestate const* statep)
+		{
+			uint64_t key = Chess::hashState(statep);
+			if (!analysis.valid || analysis.key != key) {
+				Color toMove = statep->whiteToMove ? WHITE : BLACK;
+				getAttacks(statep->board, toMove, analysis.info);
+				analysis.valid = true;
+				analysis.key = key;
+				analysis.noMoves = false;
+			}
+			return analysis;
+		}
+	}
 
-		if (pinnedElement != pinnedPositions.end() && !pinnedElement->second.contains(target))
-			continue;
+	const AttackInfo& analyseAttacks(Gamestate const* statep)
+	{
+		return analyse(statep).info;
+	}
 
-		Piece targetPiece = statep->board.get(target);
+	void reportNoMoves(Gamestate const* statep)
+	{
+		analyse(statep).noMoves = true;
+	}
 
-		if (pieceColor(targetPiece) == opponentColor(c) && targetPiece != NONE) {
+	template <Color Us>
+	bool hasPawnMove(
+		Gamestate const* statep,
+		const Coordinate& pos,
+		const AttackInfo& info
+	)
+	{
+		constexpr int direction = pawnDirection(Us);
+		Bitboard allowed = info.legalTargets(pos.square());
+		Bitboard captures = pawnAttacks[Us == WHITE][pos.square()];
+
+		if (captures & statep->board.pieces(opponentColor(Us)) & allowed)
 			// Attack a piece
-			if (mustKill && target != *mustKill)
-				continue;
-			if (mustBlock && !mustBlock->contains(target))
-				continue;
-
 			return true;
-		} else if (target == statep->passantSquare) {
-			if (mustKill && statep->passantSquare - Delta{direction, 0} != *mustKill)
-				continue;
-			if (mustBlock && !mustBlock->contains(target))
-				continue;
 
+		if (
+			statep->passantSquare != NO_SQUARE &&
+			(captures & squareBB(statep->passantSquare)) &&
+			isLegalPassant(statep->board, pos.square(), statep->passantSquare, info)
+		)
 			return true;
-		}
-	}
-
-	target = pos + Coordinate{direction, 0};
-	if (statep->board.get(target) == NONE) {
-		if (mustKill)
-			return false;
 
-		if (pinnedElement != pinnedPositions.end() && !pinnedElement->second.contains(target))
-			// If moving 1 step breaks the pin, so will moving 2 steps
+		Coordinate target = pos + Coordinate{direction, 0};
+		if (statep->board.get(target) != NONE)
 			return false;
 
 		// Move one step
-		if (!mustBlock || mustBlock->contains(target)) {
+		if (allowed & squareBB(target.square()))
 			return true;
-		}
 
-		if (pos.rank == (c == WHITE ? 1 : 6)) {
-			if (!mustBlock || mustBlock->contains(target)) {
+		if (pos.rank == (Us == WHITE ? 1 : 6)) {
+			// Move two steps, which may block a check one step doesn't
+			target = pos + Coordinate{2*direction, 0};
+			if (statep->board.get(target) == NONE && (allowed & squareBB(target.square())))
 				return true;
-			}
 		}
-	}
-
-	// Found no legal moves
-	return false;
-}
 
-bool hasKnightMove(
-	Gamestate const* statep,
-	Color c,
-	Coordinate pos,
-	std::unique_ptr<Coordinate>& mustKill,
-	std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions
-)
-{
-	for (Coordinate offset : knightMoves) {
-		Coordinate target = pos + offset;
-		if (!target.isValid())
-			continue;
-		if (mustKill && target != *mustKill)
-			continue;
-		if (mustBlock && !mustBlock->contains(target))
-			continue;
-
-		auto it = pinnedPositions.find(pos);
-		if (it != pinnedPositions.end() && !it->second.contains(target))
-			continue;
-
-		Piece targetPiece = statep->board.get(target);
-		// Empty squares are black, but this does not matter in this case
-		if (targetPiece == NONE || pieceColor(targetPiece) != c) {
-			return true;
-		}
-	}
-
-	// Found no legal moves
-	return false;
-}
-
-bool hasBishopMove(
-	Gamestate const* statep,
-	Color c,
-	Coordinate pos,
-	std::unique_ptr<Coordinate>& mustKill,
-	std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions
-)
-{
-	auto pinnedElement = pinnedPositions.find(pos);
-	bool isPinned = pinnedElement != pinnedPositions.end();
-
-	if (mustKill && !(*mustKill - pos).isDiagonal())
-		return false;
-	if (isPinned && !pinnedElement->second.step.isDiagonal())
+		// Found no legal moves
 		return false;
-
-	for (int rankDirection=-1; rankDirection<=1; rankDirection+=2) {
-		for (int fileDirection=-1; fileDirection<=1; fileDirection+=2) {
-			Delta step {rankDirection, fileDirection};
-			for (Coordinate target {pos.rank + step.rank, pos.file + step.file}; target.isValid(); target += step) {
-				bool cantMove = (mustKill && target != *mustKill) ||
-					(mustBlock && !mustBlock->contains(target)) ||
-					(isPinned && !pinnedElement->second.contains(target));
-
-				Piece targetPiece = statep->board.get(target);
-				// Empty squares are black, but this does not matter in this case
-				if (targetPiece == NONE) {
-					if (cantMove)
-						continue;
-					// Move
-					return true;
-				} else if (pieceColor(targetPiece) != c) {
-					if (cantMove)
-						continue;
-					// Attack
-					return true;
-				} else {
-					// Blocked by friendly piece, can't move further in this direction
-					return false;
-				}
-			}
-		}
 	}
-	return false;
-}
-
-bool hasRookMove(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	std::unique_ptr<Coordinate>& mustKill,
-	std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions
-)
-{
-	auto pinnedElement = pinnedPositions.find(pos);
-	bool isPinned = pinnedElement != pinnedPositions.end();
 
-	if (mustKill && !(*mustKill - pos).isStraight())
-		return false;
-	if (isPinned && !pinnedElement->second.step.isStraight())
-		return false;
-
-	// Whether to move in rank or file
-	for (int rank=0; rank<=1; rank++) {
-		for (int direction=-1; direction<=1; direction+=2) {
-			Delta step {rank*direction, (!rank)*direction};
-			for (Coordinate target {pos.rank + step.rank, pos.file + step.file}; target.isValid(); target += step) {
-				bool cantMove = (mustKill && target != *mustKill) ||
-					(mustBlock && !mustBlock->contains(target)) ||
-					(isPinned && !pinnedElement->second.contains(target));
-
-				Piece targetPiece = statep->board.get(target);
-				// Empty squares are black, but this does not matter in this case
-				if (targetPiece == NONE) {
-					if (cantMove)
-						continue;
-					// Move
-					return true;
-				} else if (pieceColor(targetPiece) != c) {
-					if (cantMove)
-						break;
-					// Attack
-					return true;
-				} else {
-					// Blocked by friendly piece, can't move further in this direction
-					return false;
-				}
-			}
-		}
+	template <Color Us>
+	bool hasTargetMove(
+		Gamestate const* statep,
+		Bitboard targets
+	)
+	{
+		// Whether the piece can move to one of the legal `targets`
+		return targets & ~statep->board.pieces(Us);
 	}
-	return false;
-}
-
-bool hasQueenMove(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	std::unique_ptr<Coordinate>& mustKill,
-	std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions
-)
-{
-	return hasBishopMove(statep, c, pos, mustKill, mustBlock, pinnedPositions) ||
-		hasRookMove(statep, c, pos, mustKill, mustBlock, pinnedPositions);
-}
-
-bool hasKingMove(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	const std::array<bool, 10>& attackedSquares
-)
-{
-	for (auto it = kingMoveOrder.begin(); it != kingMoveOrder.end(); it++) {
-		Coordinate target = pos + it->first;
-		if (!target.isValid())
-			continue;
-
-		if (attackedSquares[it->second])
-			// Square is attacked by the opponent
-			continue;
-
-		if (std::abs(it->first.file) == 2)
-			// If you can castle you can also just move one square
-			// in that direction
-			continue;
 
-		Piece targetPiece = statep->board.get(target);
-		// Empty squares are black, but this does not matter in this case
-		if (targetPiece == NONE || pieceColor(targetPiece) != c) {
-			return true;
-		}
+	template <Color Us>
+	bool hasKingMove(
+		Gamestate const* statep,
+		const AttackInfo& info
+	)
+	{
+		// If you can castle you can also just move one square in that direction
+		return hasTargetMove<Us>(statep, kingAttacks[info.kingSquare] & ~info.attacked);
 	}
 
-	// Found no legal moves
-	return false;
-}
+	template <Color Us>
+	GameStatus getGameStatus(Gamestate const* statep)
+	{
+		const Analysis& a = analyse(statep);
+		const AttackInfo& info = a.info;
+		// Amount of checks on the king
+		unsigned int amtChecks = info.amtChecks();
+
+		if (a.noMoves)
+			// Found by move generation
+			return amtChecks ? GameStatus::WIN : GameStatus::DRAW;
+
+		// 2+ attackers -> only king-moves can get out of check
+		if (amtChecks >= 2) {
+			if (hasKingMove<Us>(statep, info))
+				return GameStatus::UNDECIDED;
+			else
+				return GameStatus::WIN;
+		}
 
-GameStatus getGameStatus(Gamestate const* statep)
-{
-	if (statep->rule50Ply > 150)
-		// Forced game end after 75 moves w/o captures/pawn moves
-		return GameStatus::DRAW;
+		// The bitboards are the piece lists, so only the squares of the pieces
+		// of the player to move are visited, the king first as it most often can move
+		const Board& b = statep->board;
+		Bitboard occupied = b.occupancy();
+		bool hasMoves = hasKingMove<Us>(statep, info);
 
-	Color toMove = statep->whiteToMove ? WHITE : BLACK;
-	Coordinate kingPos = findKing(statep->board, toMove);
+		for (Bitboard pawns = b.pieces(Us, PAWN); pawns && !hasMoves; )
+			hasMoves = hasPawnMove<Us>(statep, Coordinate::fromSquare(popLsb(pawns)), info);
 
-	std::array<bool, 10> attackedSquares = {
-		false, false, false, false, false, false, false, false, false, false
-	};
-	std::unique_ptr<Coordinate> mustKill;
-	std::unique_ptr<Line> mustBlock;
-	std::map<Coordinate, Line> pinnedPositions;
+		for (Bitboard knights = b.pieces(Us, KNIGHT); knights && !hasMoves; ) {
+			unsigned int square = popLsb(knights);
+			hasMoves = hasTargetMove<Us>(statep, knightAttacks[square] & info.legalTargets(square));
+		}
 
-	// Amount of checks on the king
-	unsigned int amtChecks = getAttacks(
-		// Parameters
-		statep->board,
-		kingPos,
-		toMove,
-		// Output
-		attackedSquares,
-		mustKill,
-		mustBlock,
-		pinnedPositions
-	);
+		Bitboard queens = b.pieces(Us, QUEEN);
+		for (Bitboard diagonal = b.pieces(Us, BISHOP) | queens; diagonal && !hasMoves; ) {
+			unsigned int square = popLsb(diagonal);
+			hasMoves = hasTargetMove<Us>(statep, bishopAttacks(square, occupied) & info.legalTargets(square));
+		}
+		for (Bitboard straight = b.pieces(Us, ROOK) | queens; straight && !hasMoves; ) {
+			unsigned int square = popLsb(straight);
+			hasMoves = hasTargetMove<Us>(statep, rookAttacks(square, occupied) & info.legalTargets(square));
+		}
 
-	// 2+ attackers -> only king-moves can get out of check
-	if (amtChecks >= 2) {
-		if (hasKingMove(statep, toMove, kingPos, attackedSquares))
+		if (hasMoves) {
+			if (statep->rule50Ply >= 150)
+				// Forced game end after 75 moves w/o captures/pawn moves
+				return GameStatus::DRAW;
 			return GameStatus::UNDECIDED;
-		else
-			return GameStatus::WIN;
-	}
-
-	bool hasMoves = false;
-
-	for (int rank=0; rank<8; rank++) {
-		if (hasMoves)
-			break;
-		for (int file=0; file<8; file++) {
-			if (hasMoves)
-				break;
-			Piece p = statep->board.get({rank, file});
-			if (p != NONE && pieceColor(p) == toMove) {
-				switch (pieceType(p)) {
-					case PAWN:
-						hasMoves = hasPawnMove(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions);
-						break;
-					case KNIGHT:
-						hasMoves = hasKnightMove(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions);
-						break;
-					case BISHOP:
-						hasMoves = hasBishopMove(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions);
-						break;
-					case ROOK:
-						hasMoves = hasRookMove(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions);
-						break;
-					case QUEEN:
-						hasMoves = hasQueenMove(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions);
-						break;
-					case KING:
-						hasMoves = hasKingMove(statep, toMove, kingPos, attackedSquares);
-						break;
-					default:
-						throw std::invalid_argument("Invalid piece on board");
-						break;
-				}
-			}
 		}
-	}
 
+		if (amtChecks)
+			return GameStatus::WIN;
+		else
+			return GameStatus::DRAW;
+	}
 
-	if (hasMoves) {
-		if (statep->rule50Ply >= 150)
+	GameStatus getGameStatus(Gamestate const* statep)
+	{
+		if (statep->rule50Ply > 150)
 			// Forced game end after 75 moves w/o captures/pawn moves
 			return GameStatus::DRAW;
-		return GameStatus::UNDECIDED;
-	}
 
-	if (amtChecks)
-		return GameStatus::WIN;
-	else
-		return GameStatus::DRAW;
+		if (statep->whiteToMove)
+			return getGameStatus<WHITE>(statep);
+		else
+			return getGameStatus<BLACK>(statep);
+	}
 }
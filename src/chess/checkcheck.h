@@ -1,15 +1,28 @@
-#ifndef CHECKCHECK_H_INCLUDED
-#define CHECKCHECK_H_INCLUDED
+#ifndef CHESS_CHECKCHECK_H_INCLUDED
+#define CHESS_CHECKCHECK_H_INCLUDED
 
 #include "states.h"
+#include "attacks.h"
 
-enum class GameStatus
+namespace chess
 {
-	WIN,
-	DRAW,
-	UNDECIDED
-};
+	enum class GameStatus
+	{
+		WIN,
+		DRAW,
+		UNDECIDED
+	};
 
-GameStatus getGameStatus(Gamestate const* statep);
+	GameStatus getGameStatus(Gamestate const* statep);
+
+	// Checks and pins on the king of the player to move
+	// Each thread remembers the last gamestate it analysed, so move generation,
+	// game status detection and evaluation of a gamestate only find them once
+	const AttackInfo& analyseAttacks(Gamestate const* statep);
+
+	// Report that generating every legal move of the gamestate found none, so
+	// getGameStatus doesn't look for them again
+	void reportNoMoves(Gamestate const* statep);
+}
 
 #endif
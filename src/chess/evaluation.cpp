@@ -3,48 +3,42 @@
 #include "states.h"
 #include "pieces.h"
 #include "checkcheck.h"
-#include "../game.h"
 
-float materialCount(const Board& b)
+namespace chess
 {
-	float count = 0;
-	for (int rank=0; rank<8; rank++)
-		for (int file=0; file<8; file++) {
-			Piece tmpPiece = b.get({rank, file});
-			count += pawnDirection(pieceColor(tmpPiece)) * materialValue[pieceType(tmpPiece)];
-		}
-	return count;
-}
-
-float psqtScore(const Board& b)
-{
-	float score = 0;
-	for (int rank=0; rank<8; rank++)
-		for (int file=0; file<8; file++)
-			score += PSQT[b.get({rank, file})][rank][file];
-	return score;
-}
+	float materialCount(const Board& b)
+	{
+		// Kept up to date by Board::set
+		return b.material;
+	}
 
-float evaluation(Gamestate const* statep) {
-	GameStatus status = getGameStatus(statep);
-	switch (status) {
-		case GameStatus::WIN:
-			return (statep->whiteToMove ? -100 : 100);
-		case GameStatus::DRAW:
-			return 0;
-		case GameStatus::UNDECIDED:
-			break;
+	float psqtScore(const Board& b)
+	{
+		// Kept up to date by Board::set, in centipawns
+		return b.psqt / 100.0f;
 	}
 
-	if (statep->rule50Ply >= 100)
-		// Both players can claim a draw
-		return 0;
+	float Chess::evaluation(Gamestate const* statep) {
+		GameStatus status = getGameStatus(statep);
+		switch (status) {
+			case GameStatus::WIN:
+				return (statep->whiteToMove ? -100 : 100);
+			case GameStatus::DRAW:
+				return 0;
+			case GameStatus::UNDECIDED:
+				break;
+		}
 
-	return psqtScore(statep->board);
-	//return materialCount(statep->board);
-}
+		if (statep->rule50Ply >= 100)
+			// Both players can claim a draw
+			return 0;
 
-bool gameOver(Gamestate const* statep)
-{
-	return getGameStatus(statep) != GameStatus::UNDECIDED;
+		return psqtScore(statep->board);
+		//return materialCount(statep->board);
+	}
+
+	bool gameOver(Gamestate const* statep)
+	{
+		return getGameStatus(statep) != GameStatus::UNDECIDED;
+	}
 }
@@ -1,23 +1,20 @@
-#ifndef EVALUATION_H_INCLUDED
-#define EVALUATION_H_INCLUDED
-
-#include "../game.h"
+#ifndef CHESS_EVALUATION_H_INCLUDED
+#define CHESS_EVALUATION_H_INCLUDED
 
 #include "states.h"
 
 // PSQT
 #include "psqt.h"
 
-// float evaluation(...) is declared in ../game.h
-
-bool gameOver(Gamestate const* statep);
-
-inline constexpr float materialValue[7] = {0, 1, 3, 3, 5, 9, 0};
+namespace chess
+{
+	bool gameOver(Gamestate const* statep);
 
-float materialCount(const Board& b);
+	inline constexpr float materialValue[7] = {0, 1, 3, 3, 5, 9, 0};
 
-float psqtScore(const Board& b);
+	float materialCount(const Board& b);
 
-float evaluation(Gamestate const* statep);
+	float psqtScore(const Board& b);
+}
 
 #endif
@@ -0,0 +1,142 @@
+#include "magic.h"
+
+#include "bitboard.h"
+
+#include <stdexcept>
+
+namespace chess
+{
+	Magic bishopMagics[64];
+	Magic rookMagics[64];
+
+	namespace
+	{
+		constexpr int BISHOP_DIRECTIONS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+		constexpr int ROOK_DIRECTIONS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+		// Magic numbers of each square, found once by trying sparse random
+		// numbers until one maps every occupancy to an index without collisions
+		constexpr Bitboard BISHOP_MAGICS[64] = {
+			0x9208010408104500, 0x18a0020882208410, 0x4042020200200288, 0x0004410222010200,
+			0x000404200a000800, 0x8228245048400024, 0x0020840402c08000, 0x002042444420200c,
+			0x3400481030089920, 0x4000129818430440, 0x0200880204082000, 0x2000040400854004,
+			0x82289c04a0108000, 0x0000860292201432, 0x1000449c01209080, 0x0101390100822000,
+			0x8004002084100201, 0x0820011011023280, 0x000510220c010200, 0x0048000082004000,
+			0x0004040280a00200, 0xe24101b601108200, 0x0900804064042007, 0x40862049c2025010,
+			0x40a0082085100404, 0x2510144409010414, 0x0006500048022040, 0x4824040000401280,
+			0x0002840002822000, 0x1001010102006103, 0x104800804202018c, 0x80a0882a01050800,
+			0x0382029010411000, 0x0808016800840800, 0x4089080100020400, 0x2000020080080081,
+			0x2200410041040040, 0x0001104200210100, 0x8010310044090400, 0x81088a00882200a0,
+			0x0002021104004108, 0x8404012110334811, 0x000010109000c800, 0x0000802018000102,
+			0x0200180104010111, 0x0104150641008202, 0x0104088200401400, 0x10101400908c0022,
+			0x1000414820108210, 0x0022010402224700, 0x0000228048220110, 0x0104000c20884081,
+			0x00248a4803040240, 0x20a020080a982010, 0x0408208404005023, 0x8904880204003010,
+			0x0320410088014028, 0x0204b20200840440, 0x2800800100809002, 0x0008180109228808,
+			0x0031000289430400, 0x4811402004018200, 0x4000088918280040, 0x0040620420420048
+		};
+		constexpr Bitboard ROOK_MAGICS[64] = {
+			0x0080001020804000, 0x2540011000200042, 0x0a80200208100080, 0x4080080080041000,
+			0x0200200402000810, 0x0100040001000802, 0x410000a100020044, 0x02000c0080204102,
+			0x0852800080400024, 0x0050401000402000, 0x0802004026001080, 0x812a0008c1209200,
+			0x1040808008000400, 0x1040808004000200, 0x1600800100800200, 0x0001000200608100,
+			0x0900208000400080, 0x0004888040002000, 0x0002020040802010, 0x0008008008100080,
+			0x0204018004811800, 0x2100808004000200, 0x4141040010414802, 0x500412000d006084,
+			0x0200408200210200, 0x0000500040002000, 0x4000200100401104, 0x0088100100200900,
+			0xc000040080080080, 0x1002000200100408, 0x0050410400100208, 0x3000050600004084,
+			0x0450284000800084, 0x8804200044401004, 0x10b2860012002040, 0x1400800800801000,
+			0x0820040080800800, 0x1004800201800400, 0x0020900804002122, 0x895024204a000081,
+			0xc1800020044a4002, 0x0001e00050014000, 0x01402000c3030014, 0x4208102200420009,
+			0x20c0080011010004, 0x0412000804020011, 0x1084020001008080, 0x00002041008a0014,
+			0x08032049048a0200, 0xa040400020008280, 0x800c200101104100, 0x6080100100082100,
+			0x1148000400288180, 0x4002004884908200, 0x1101111a28902400, 0x0120010400804200,
+			0x040010210200408a, 0x0029020040208812, 0x0001401308820022, 0x0804050008100021,
+			0x104100901c024801, 0x0102000881041002, 0x0080008108021004, 0x0000110c0080c022
+		};
+
+		// Total size of the attack tables of all squares, 2^(relevant squares) each
+		constexpr unsigned int BISHOP_TABLE_SIZE = 5248;
+		constexpr unsigned int ROOK_TABLE_SIZE = 102400;
+
+		Bitboard bishopTable[BISHOP_TABLE_SIZE];
+		Bitboard rookTable[ROOK_TABLE_SIZE];
+
+		Bitboard slidingAttacks(unsigned int square, Bitboard occupied, const int (&directions)[4][2])
+		{
+			// Step through each direction until the edge or a blocker, slow but
+			// only used to fill the tables
+			Bitboard attacks = 0;
+			for (const auto& direction : directions) {
+				int rank = square / 8 + direction[0];
+				int file = square % 8 + direction[1];
+				for (; rank >= 0 && rank < 8 && file >= 0 && file < 8; rank += direction[0], file += direction[1]) {
+					attacks |= squareBB(rank * 8 + file);
+					if (occupied & squareBB(rank * 8 + file))
+						break;
+				}
+			}
+			return attacks;
+		}
+
+		Bitboard relevantMask(unsigned int square, const int (&directions)[4][2])
+		{
+			// The last square in each direction is attacked whether it is occupied or not
+			Bitboard mask = 0;
+			for (const auto& direction : directions) {
+				int rank = square / 8 + direction[0];
+				int file = square % 8 + direction[1];
+				int nextRank = rank + direction[0];
+				int nextFile = file + direction[1];
+				for (; nextRank >= 0 && nextRank < 8 && nextFile >= 0 && nextFile < 8; nextRank += direction[0], nextFile += direction[1]) {
+					mask |= squareBB(rank * 8 + file);
+					rank = nextRank;
+					file = nextFile;
+				}
+			}
+			return mask;
+		}
+
+		void initMagics(Magic (&magics)[64], const Bitboard (&magicNumbers)[64], Bitboard* table, unsigned int tableSize, const int (&directions)[4][2])
+		{
+			Bitboard* attacks = table;
+			for (unsigned int square=0; square<64; square++) {
+				Magic& m = magics[square];
+				m.mask = relevantMask(square, directions);
+				m.magic = magicNumbers[square];
+				m.shift = 64 - popcount(m.mask);
+				m.attacks = attacks;
+
+				unsigned int size = 1u << popcount(m.mask);
+				if (attacks + size > table + tableSize)
+					throw std::logic_error("Slider attack table too small");
+
+				// Fill the table for all subsets of the mask (Carry-Rippler)
+				// Different occupancies sharing an index must have the same attacks
+				for (unsigned int i=0; i<size; i++)
+					attacks[i] = 0;
+				Bitboard occupied = 0;
+				do {
+					Bitboard reference = slidingAttacks(square, occupied, directions);
+					Bitboard& entry = attacks[m.index(occupied)];
+					if (entry != 0 && entry != reference)
+						throw std::logic_error("Invalid magic number");
+					entry = reference;
+					occupied = (occupied - m.mask) & m.mask;
+				} while (occupied);
+
+				attacks += size;
+			}
+		}
+
+		struct MagicInit
+		{
+			MagicInit()
+			{
+				initMagics(bishopMagics, BISHOP_MAGICS, bishopTable, BISHOP_TABLE_SIZE, BISHOP_DIRECTIONS);
+				initMagics(rookMagics, ROOK_MAGICS, rookTable, ROOK_TABLE_SIZE, ROOK_DIRECTIONS);
+			}
+		};
+
+		// Fill the tables at startup, before main
+		const MagicInit magicInit;
+	}
+}
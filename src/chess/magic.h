@@ -0,0 +1,58 @@
+#ifndef CHESS_MAGIC_H_INCLUDED
+#define CHESS_MAGIC_H_INCLUDED
+
+#include "bitboard.h"
+
+#ifdef USE_PEXT
+#include <immintrin.h>
+#endif
+
+namespace chess
+{
+	// Attack tables of bishops and rooks, indexed by the occupancy of the squares
+	// that can block them. With magic bitboards the index is found by multiplying
+	// the occupancy by a precomputed number, so the relevant bits end up at
+	// the top. Building with USE_PEXT (make PEXT=1) extracts them with the BMI2
+	// pext instruction instead, which is faster on CPUs that implement it in hardware.
+	struct Magic
+	{
+		// Squares whose occupancy changes the attacks, the edges of the board never do
+		Bitboard mask;
+		Bitboard magic;
+		unsigned int shift;
+		Bitboard const* attacks;
+
+		inline unsigned int index(Bitboard occupied) const
+		{
+#ifdef USE_PEXT
+			return _pext_u64(occupied, mask);
+#else
+			return ((occupied & mask) * magic) >> shift;
+#endif
+		}
+	};
+
+	extern Magic bishopMagics[64];
+	extern Magic rookMagics[64];
+
+	// Squares attacked by a slider on `square`, including the first blocker in
+	// each direction regardless of its color
+	inline Bitboard bishopAttacks(unsigned int square, Bitboard occupied)
+	{
+		const Magic& m = bishopMagics[square];
+		return m.attacks[m.index(occupied)];
+	}
+
+	inline Bitboard rookAttacks(unsigned int square, Bitboard occupied)
+	{
+		const Magic& m = rookMagics[square];
+		return m.attacks[m.index(occupied)];
+	}
+
+	inline Bitboard queenAttacks(unsigned int square, Bitboard occupied)
+	{
+		return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+	}
+}
+
+#endif
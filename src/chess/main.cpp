@@ -1,13 +1,20 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <chrono>
+#include <algorithm>
+#include <thread>
 
 #include "states.h"
 #include "evaluation.h"
 #include "../trees.h"
 
+using namespace chess;
+
 #define VALIDATE false
 #define TEST false
+#define BENCH false
+#define PERFT false
 #define PLAY true
 
 #if VALIDATE
@@ -15,16 +22,21 @@ int main()
 {
 	// Read a fen from stdin and write all legal moves to stdout
 	// Used to validate the move-generation
+	// At the end of the input, the time taken to read and write the FENs is
+	// written to stderr
 	std::string FEN;
 	Gamestate s;
 
 	std::vector<Gamestate*> states;
 	std::vector<Action*> actions;
+	std::vector<std::string> FENs;
 
 	while (std::getline(std::cin, FEN)) {
+		FENs.push_back(FEN);
+
 		// Test FEN -> gamestate
 		try {
-			s = FEN;
+			s = Gamestate{FEN};
 		} catch (const std::invalid_argument& ia) {
 			std::cerr << ia.what() << std::endl;
 			return 1;
@@ -38,7 +50,7 @@ int main()
 			return 1;
 		}
 
-		genChildren(&s, states, actions);
+		Chess::genChildren(&s, states, actions);
 		for (unsigned int i=0; i<actions.size(); i++) {
 			std::cout << actions[i]->toAN() << "\t"
 				<< states[i]->toFEN() << std::endl;
@@ -51,6 +63,30 @@ int main()
 
 		std::cout << "DONE" << std::endl;
 	}
+
+	// Read and write every FEN again, enough times to measure
+	constexpr unsigned int ROUNDS = 100;
+	std::vector<Gamestate> read (FENs.size());
+	size_t FENLength = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int round=0; round<ROUNDS; round++)
+		for (size_t i=0; i<FENs.size(); i++)
+			read[i] = Gamestate{FENs[i]};
+	auto readEnd = std::chrono::steady_clock::now();
+	for (unsigned int round=0; round<ROUNDS; round++)
+		for (const Gamestate& state : read)
+			FENLength += state.toFEN().size();
+	auto writeEnd = std::chrono::steady_clock::now();
+
+	double amtFENs = static_cast<double>(FENs.size()) * ROUNDS;
+	std::chrono::duration<double> readTime = readEnd - start;
+	std::chrono::duration<double> writeTime = writeEnd - readEnd;
+	if (amtFENs)
+		std::cerr << FENs.size() << " FENs, " << ROUNDS << " rounds\t"
+			<< readTime.count() / amtFENs * 1e9 << " ns/read\t"
+			<< writeTime.count() / amtFENs * 1e9 << " ns/write\t"
+			<< FENLength << " characters written" << std::endl;
 	return 0;
 }
 #endif // VALIDATE
@@ -166,7 +202,7 @@ int main()
 	FEN = "6k1/8/4p3/P2rPp1K/1P2R2P/5RP1/1r6/8 w - f6 0 1";
 
 	try {
-		s = FEN;
+		s = Gamestate{FEN};
 	} catch (const std::invalid_argument& ia) {
 		std::cerr << ia.what() << std::endl;
 		return 1;
@@ -180,12 +216,12 @@ int main()
 
 	unsigned int depth = 1;
 
-	Evaluation e = bestAction(&s, depth);
+	Evaluation<Chess> e = bestAction<Chess>(&s, depth);
 	(void) e;
 
 	std::vector<Gamestate*> states;
 	std::vector<Action*> actions;
-	genChildren(&s, states, actions);
+	Chess::genChildren(&s, states, actions);
 
 	std::cout << actions.size() << " valid move(s)" << std::endl;
 	for (unsigned int i=0; i<actions.size(); i++) {
@@ -197,6 +233,182 @@ int main()
 #endif // TEST
 
 
+#if BENCH
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+// Heap allocations made by all threads, to check that the search doesn't allocate
+std::atomic<uint64_t> allocations {0};
+
+void* operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+int main()
+{
+	// Search a fixed set of positions to a fixed depth, first on one thread
+	// and then on all available threads, and report time-to-depth
+	// Done with each way of generating moves, to report which is faster
+	const std::string positions[] = {
+		STARTING_FEN,
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"4q1k1/p5b1/1p4pp/nRr1Pp2/Q1p2B2/3b1N2/P4PPP/4R1K1 w - - 2 26",
+		"rnbqkb1r/1p2pppp/p2p1n2/8/3NP3/2N5/PPP2PPP/R1BQKB1R w KQkq - 0 6",
+		"3k2nr/3b1p2/3p3b/p1rNn2p/5QpN/1BP5/PP1K1PPP/R6R w - - 11 1",
+		"6r1/5Rpk/1Q5p/2P1p3/6P1/1P2q3/P5PK/8 w - - 0 1",
+	};
+
+	unsigned int depth = 5;
+	unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	const std::pair<MoveGeneration, std::string> generations[] = {
+		{MoveGeneration::LEGAL, "legal"},
+		{MoveGeneration::PSEUDO_LEGAL, "pseudo-legal"},
+	};
+	// Single thread time-to-depth of each way of generating moves
+	std::vector<double> generationTimes;
+
+	for (const auto& [generation, name] : generations) {
+		setMoveGeneration(generation);
+		std::cout << "Move generation: " << name << std::endl << std::endl;
+
+		for (unsigned int threads : {1u, maxThreads}) {
+			setSearchThreads(threads);
+
+			uint64_t totalNodes = 0;
+			uint64_t totalAllocations = 0;
+			std::chrono::duration<double> totalTime {0};
+
+			for (const std::string& FEN : positions) {
+				Gamestate s {FEN};
+				clearHash();
+
+				uint64_t startAllocations = allocations;
+				auto start = std::chrono::steady_clock::now();
+				Evaluation<Chess> e = bestAction<Chess>(&s, depth);
+				std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+				uint64_t searchAllocations = allocations - startAllocations;
+
+				totalNodes += searchedNodes();
+				totalAllocations += searchAllocations;
+				totalTime += elapsed;
+
+				std::cout << FEN << std::endl
+					<< "\t" << e.action->toAN() << "\t" << e.evaluation
+					<< "\t" << searchedNodes() << " nodes\t" << elapsed.count() << "s"
+					<< "\t" << searchAllocations << " allocations" << std::endl;
+				delete e.action;
+			}
+
+			std::cout << threads << " thread(s):\t"
+				<< totalNodes << " nodes\t"
+				<< totalTime.count() << "s\t"
+				<< static_cast<uint64_t>(totalNodes / totalTime.count()) << " nps\t"
+				<< static_cast<double>(totalAllocations) / totalNodes << " allocations/node" << std::endl << std::endl;
+
+			if (threads == 1)
+				generationTimes.push_back(totalTime.count());
+			if (threads == maxThreads)
+				break;
+		}
+	}
+
+	size_t fastest = std::min_element(generationTimes.begin(), generationTimes.end()) - generationTimes.begin();
+	std::cout << "Fastest move generation: " << generations[fastest].second << std::endl;
+	for (size_t i=0; i<generationTimes.size(); i++)
+		std::cout << "\t" << generations[i].second << "\t" << generationTimes[i] << "s" << std::endl;
+
+	return 0;
+}
+#endif // BENCH
+
+
+#if PERFT
+#include "perft.h"
+
+int main()
+{
+	// Count the leaf nodes below positions with known counts, first counting
+	// every subtree and then with a hash table, on all available threads
+	// A wrong count is followed by the counts below each root action, to
+	// find the wrong move by comparing with another move generator
+	struct Reference
+	{
+		std::string FEN;
+		unsigned int depth;
+		uint64_t nodes;
+	};
+
+	const Reference references[] = {
+		{STARTING_FEN, 5, 4865609},
+		{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+		{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083},
+		{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292},
+		{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+		{"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594},
+	};
+
+	PerftOptions options;
+	options.threads = std::max(1u, std::thread::hardware_concurrency());
+	bool correct = true;
+
+	for (size_t hashMegabytes : {0, 64}) {
+		options.hashMegabytes = hashMegabytes;
+
+		uint64_t totalNodes = 0;
+		std::chrono::duration<double> totalTime {0};
+
+		for (const Reference& reference : references) {
+			Gamestate s {reference.FEN};
+
+			auto start = std::chrono::steady_clock::now();
+			std::vector<PerftCount> counts = divide(s, reference.depth, options);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			uint64_t nodes = 0;
+			for (const PerftCount& count : counts)
+				nodes += count.nodes;
+			totalNodes += nodes;
+			totalTime += elapsed;
+
+			std::cout << reference.FEN << std::endl
+				<< "\tdepth " << reference.depth << "\t" << nodes << " nodes\t" << elapsed.count() << "s";
+			if (nodes == reference.nodes) {
+				std::cout << "\tcorrect" << std::endl;
+			} else {
+				correct = false;
+				std::cout << "\twrong, expected " << reference.nodes << std::endl;
+				for (const PerftCount& count : counts)
+					std::cout << "\t\t" << count.action.toAN() << ": " << count.nodes << std::endl;
+			}
+		}
+
+		std::cout << options.threads << " thread(s), " << hashMegabytes << " MB hash:\t"
+			<< totalNodes << " nodes\t"
+			<< totalTime.count() << "s\t"
+			<< static_cast<uint64_t>(totalNodes / totalTime.count()) << " nps" << std::endl << std::endl;
+	}
+
+	return correct ? 0 : 1;
+}
+#endif // PERFT
+
+
 #if PLAY
 int main()
 {
@@ -269,46 +481,49 @@ int main()
 		return 1;
 	}
 
-	unsigned int depth = 5;
+	// Think for at most 5 seconds per move
+	SearchLimits limits;
+	limits.time = std::chrono::seconds(5);
 	bool player = true;
 	bool playerWhite = true;
 
-	Evaluation e;
+	setSearchThreads(std::thread::hardware_concurrency());
+
+	Evaluation<Chess> e;
 
 	std::cout << std::endl;
 	std::cout << sp->toString() << std::endl;
-	std::cout << "State evaluation:\t" << evaluation(sp) << std::endl;
+	std::cout << "State evaluation:\t" << Chess::evaluation(sp) << std::endl;
 	sp->board.print(playerWhite ? WHITE : BLACK, true);
 
 	std::vector<Gamestate*> states;
 	std::vector<Action*> actions;
 
 	while (!gameOver(sp)) {
-		Action a{{0,0},{0,0}};
+		Action a;
 		std::string tmp;
 
-		genChildren(sp, states, actions);
+		Chess::genChildren(sp, states, actions);
 
 		if (player && sp->whiteToMove == playerWhite) {
 			// No input-validation
 			std::cin >> tmp;
-			Coordinate from = {tmp};
+			std::string AN {tmp};
 			std::cin >> tmp;
-			Coordinate to = {tmp};
-			Piece tmpPiece = sp->board.get(from);
-			if (pieceType(tmpPiece) == PAWN && from.rank == (sp->whiteToMove ? 6 : 1)) {
+			AN += tmp;
+			Piece tmpPiece = sp->board.get(Coordinate{AN.substr(0, 2)});
+			if (pieceType(tmpPiece) == PAWN && AN[1] == (sp->whiteToMove ? '7' : '2')) {
 				std::cin >> tmp;
-				Piece pp = symbolToPiece(tmp[0]);
-				a = {from, to, pp};
-			} else {
-				a = {from, to};
+				AN += pieceToSymbol[pieceType(symbolToPiece(tmp[0]))];
 			}
+			a = Action::fromAN(AN, *sp);
 
 			std::cout << std::endl;
 		} else {
-			e = bestAction(sp, depth);
+			e = bestAction<Chess>(sp, limits);
 			a = *e.action;
 			std::cout << "Node evaluation:\t" << (sp->whiteToMove ? 1 : -1) * e.evaluation << std::endl;
+			std::cout << "Search depth:\t" << e.depth << std::endl;
 			std::cout << "Computer plays:\t" << e.action->toString() << std::endl;
 		}
 
@@ -325,7 +540,7 @@ int main()
 		// Print state
 		std::cout << std::endl;
 		std::cout << sp->toString() << std::endl;
-		std::cout << "State evaluation:\t" << evaluation(sp) << std::endl;
+		std::cout << "State evaluation:\t" << Chess::evaluation(sp) << std::endl;
 		sp->board.print(playerWhite ? WHITE : BLACK, true);
 
 		// If both players are computers or the player is making the next move
@@ -351,7 +566,7 @@ int main()
 	sp->board.print(playerWhite ? WHITE : BLACK, true);
 
 	std::cout << e.evaluation << std::endl;
-	std::cout << evaluation(sp) << std::endl;
+	std::cout << Chess::evaluation(sp) << std::endl;
 
 	return 0;
 }
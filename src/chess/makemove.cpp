@@ -0,0 +1,173 @@
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "board.h"
+#include "states.h"
+#include "attacks.h"
+
+namespace chess
+{
+	namespace
+	{
+		// Castling rights lost when a move departs from or arrives on each square:
+		// the king and rook home squares
+		constexpr std::array<uint8_t, 64> castlingLost = [] {
+			std::array<uint8_t, 64> lost {};
+			lost[0] = WHITE_QUEENSIDE;
+			lost[4] = WHITE_KINGSIDE | WHITE_QUEENSIDE;
+			lost[7] = WHITE_KINGSIDE;
+			lost[56] = BLACK_QUEENSIDE;
+			lost[60] = BLACK_KINGSIDE | BLACK_QUEENSIDE;
+			lost[63] = BLACK_KINGSIDE;
+			return lost;
+		}();
+	}
+
+	void makeMove(Gamestate& state, const Action& action, Undo& undo)
+	{
+		Coordinate from = action.from();
+		Coordinate to = action.to();
+
+		Color toMove = state.whiteToMove ? WHITE : BLACK;
+		int homeRank = toMove == WHITE ? 0 : 7;
+		Piece movedPiece = state.board.get(from);
+
+		undo = {state.board.get(to), state.castling, state.passantSquare, state.rule50Ply};
+
+		// Update ply since capture/pawn move
+		if (undo.captured != NONE || pieceType(movedPiece) == PAWN)
+			state.rule50Ply = 0;
+		else
+			state.rule50Ply++;
+
+		// Update en passant
+		state.passantSquare = NO_SQUARE;
+
+		switch (pieceType(movedPiece)) {
+			case PAWN:
+				if (action.isPassant()) {
+					// En passant, the captured pawn is next to the moving one
+					Coordinate pawnPos {from.rank, to.file};
+					undo.captured = state.board.get(pawnPos);
+					state.board.set(pawnPos, NONE);
+				} else if (std::abs(to.rank - from.rank) == 2) {
+					state.passantSquare = Coordinate{(from.rank + to.rank) / 2, from.file}.square();
+				}
+				break;
+			case KING:
+				if (action.isCastle()) {
+					// Castle, move the rook
+					if (to.file < from.file)
+						state.board.move({homeRank, 0}, {homeRank, 3});
+					else
+						state.board.move({homeRank, 7}, {homeRank, 5});
+				}
+				break;
+			default:
+				break;
+		}
+
+		// Moving the king or a rook, or capturing a rook, loses castling-rights
+		state.castling &= ~(castlingLost[from.square()] | castlingLost[to.square()]);
+
+		if (action.isPromotion()) {
+			state.board.set(from, NONE);
+			state.board.set(to, toMove | action.promotionPiece());
+		} else {
+			state.board.move(from, to);
+		}
+
+		// Update toMove
+		state.whiteToMove = !state.whiteToMove;
+	}
+
+	void unmakeMove(Gamestate& state, const Action& action, const Undo& undo)
+	{
+		Coordinate from = action.from();
+		Coordinate to = action.to();
+
+		state.whiteToMove = !state.whiteToMove;
+
+		Color toMove = state.whiteToMove ? WHITE : BLACK;
+		int homeRank = toMove == WHITE ? 0 : 7;
+
+		if (action.isPromotion()) {
+			state.board.set(from, toMove | PAWN);
+			state.board.set(to, undo.captured);
+		} else {
+			state.board.move(to, from);
+
+			if (action.isPassant()) {
+				// En passant
+				state.board.set({from.rank, to.file}, undo.captured);
+			} else if (undo.captured != NONE) {
+				state.board.set(to, undo.captured);
+			} else if (action.isCastle()) {
+				// Castle, move the rook back
+				if (to.file < from.file)
+					state.board.move({homeRank, 3}, {homeRank, 0});
+				else
+					state.board.move({homeRank, 5}, {homeRank, 7});
+			}
+		}
+
+		state.castling = undo.castling;
+		state.passantSquare = undo.passantSquare;
+		state.rule50Ply = undo.rule50Ply;
+	}
+
+	namespace
+	{
+		// Undo records of the in-place interface, per thread and indexed by ply
+		thread_local std::vector<Undo> undoStack;
+
+		Undo& undoAt(unsigned int ply)
+		{
+			if (ply >= undoStack.size())
+				undoStack.resize(ply + 1);
+			return undoStack[ply];
+		}
+	}
+
+	void Chess::makeMove(Gamestate& state, Action const* actionp, unsigned int ply)
+	{
+		chess::makeMove(state, *actionp, undoAt(ply));
+	}
+
+	void Chess::unmakeMove(Gamestate& state, Action const* actionp, unsigned int ply)
+	{
+		chess::unmakeMove(state, *actionp, undoStack[ply]);
+	}
+
+	bool Chess::makeNullMove(Gamestate& state, unsigned int ply)
+	{
+		Color toMove = state.whiteToMove ? WHITE : BLACK;
+
+		// With only pawns and the king, every move may make the position worse,
+		// so passing would overestimate it
+		Bitboard pieces = state.board.pieces(toMove) & ~state.board.pieces(PAWN) & ~state.board.pieces(KING);
+		if (!pieces)
+			return false;
+
+		// Passing in check would leave the king to be captured
+		unsigned int kingSquare = state.board.kingSquare(toMove);
+		if (attackersTo(state.board, kingSquare, state.board.occupancy()) & state.board.pieces(opponentColor(toMove)))
+			return false;
+
+		undoAt(ply) = {NONE, state.castling, state.passantSquare, state.rule50Ply};
+
+		state.whiteToMove = !state.whiteToMove;
+		state.passantSquare = NO_SQUARE;
+		state.rule50Ply++;
+		return true;
+	}
+
+	void Chess::unmakeNullMove(Gamestate& state, unsigned int ply)
+	{
+		const Undo& undo = undoStack[ply];
+		state.whiteToMove = !state.whiteToMove;
+		state.passantSquare = undo.passantSquare;
+		state.rule50Ply = undo.rule50Ply;
+	}
+}
@@ -1,8 +1,6 @@
 //#define NDEBUG
 
 #include <cmath>
-#include <map>
-#include <memory>
 #include <array>
 #include <algorithm>
 #include <stdexcept>
@@ -11,537 +9,737 @@
 #include "board.h"
 #include "states.h"
 #include "attacks.h"
+#include "checkcheck.h"
+#include "magic.h"
 #include "evaluation.h"
 #include "../game.h"
 
-Gamestate* insertChild(Gamestate const* current, const Coordinate& from, const Coordinate& to, Piece promotion, float score, std::vector<ChildNode>& children)
+namespace chess
 {
-	// Insert a new child into `children` and return a pointer to the newly created gamestate
-	// Creates new `Action` and `Gamestate` objects, and handles some of the
-	// new state logic:
-	// 	Castling rights are revoked when a rook is captured
-	// 	`whiteToMove` is updated
-	// 	`passantSquare` is reset
-	// 	`board.move(from, to)` is executed
-	// 	Pawns are properly promoted when `promotion` != `NONE`
-	// 	`rule50Ply` is incremented
-
-	// Callers must be sure to:
-	// 	Set `passantSquare` when relevant
-	// 	Revoke castling rights when castling or moving a rook
-	// 	Reset `rule50Ply` when moving a pawn of capturing a piece
-	//	Perform side effects: moving rooks when castling, removing pawns when en passant
-
-	Gamestate* newstatep = new Gamestate{*current};
-	Action* newactionp = new Action{from, to, promotion};
-
-	Color toMove = newstatep->whiteToMove ? WHITE : BLACK;
-
-	Piece targetPiece = newstatep->board.get(to);
-	if (targetPiece != NONE)
-		// Search moves using smaller attackers first
-		score -= materialValue[pieceType(newstatep->board.get(from))] / 10;
-
-	// Test if a rook is being captured
-	if (to.rank == (toMove == WHITE ? 7 : 0)) {
-		// Unset queen-/kingside castling-rights if capturing on a or h
-		switch (to.file) {
-			case 0:
-				(newstatep->whiteToMove ? newstatep->blackCastle : newstatep->whiteCastle).queenside = false;
-				break;
-			case 7:
-				(newstatep->whiteToMove ? newstatep->blackCastle : newstatep->whiteCastle).kingside = false;
-				break;
-			default:
-				break;
-		}
-	}
-
-	// Update toMove
-	newstatep->whiteToMove = !newstatep->whiteToMove;
+	// Move ordering bonus for quiet moves, in pawns
+	// Small compared to captures, so it mostly breaks ties between quiet moves
+	constexpr float HISTORY_WEIGHT = 0.3;
+
+	// Range of material gain of the moves to generate
+	// Quiet moves gain 0, captures the value of the captured piece, and
+	// promotions the value of the new piece minus that of the pawn
+	struct GainRange
+	{
+		float min;
+		float max;
+
+		bool contains(float gain) const { return gain >= min && gain <= max; }
+	};
 
-	// Update en passant
-	newstatep->passantSquare.rank = -1;
-	newstatep->passantSquare.file = -1;
+	constexpr GainRange ALL_MOVES {-INFINITY, INFINITY};
+	constexpr GainRange QUIET_MOVES {-INFINITY, 0};
+	constexpr GainRange CAPTURE_MOVES {materialValue[PAWN], INFINITY};
 
-	if (promotion != NONE) {
-		newstatep->board.set(from, NONE);
-		newstatep->board.set(to, toMove | promotion);
-	} else {
-		newstatep->board.move(from, to);
-	}
+	// The generators below are instantiated for each color, so the pawn
+	// direction, promotion rank and castling squares are constants
+	// genMoves and genPieceMoves pick the instance for the player to move
 
-	// Update ply since capture/pawn move
-	newstatep->rule50Ply++;
+	template <Color Us>
+	void insertAction(Gamestate const* statep, const Coordinate& from, const Coordinate& to, unsigned int flags, float score, std::vector<ScoredAction>& actions)
+	{
+		// Insert a new action into `actions`, scored for move ordering
+		// All side effects of the move are handled by `makeMove`
 
-	// Search obvious moves first
-	score += pawnDirection(toMove) * psqtScore(newstatep->board);
+		Action action {from, to, flags};
+		Piece promotion = action.promotionPiece();
 
-	ChildNode newChild {newstatep, newactionp, score};
+		Piece movedPiece = statep->board.get(from);
+		Piece targetPiece = statep->board.get(to);
 
-	// Insert new children in descending order
-	std::vector<ChildNode>::iterator it = std::lower_bound(children.begin(), children.end(), newChild);
-	children.insert(it, newChild);
-
-	return newstatep;
-}
+		if (Chess::isQuiet(statep, &action)) {
+			// Search quiet moves that caused cutoffs elsewhere in the tree first
+			score += HISTORY_WEIGHT * historyScore(Chess::actionKey(&action));
+		}
 
-inline Gamestate* insertChild(Gamestate const* current, const Coordinate& from, const Coordinate& to, std::vector<ChildNode>& children)
-{
-	return insertChild(current, from, to, NONE, 0, children);
-}
+		// Search obvious moves first, by the change in PSQT score
+		Piece placedPiece = promotion != NONE ? (Us | promotion) : movedPiece;
+		float psqtDelta = PSQT[placedPiece][to.rank][to.file] -
+			PSQT[movedPiece][from.rank][from.file] -
+			PSQT[targetPiece][to.rank][to.file];
 
+		if (action.isPassant()) {
+			// En passant
+			Piece passantPawn = opponentColor(Us) | PAWN;
+			psqtDelta -= PSQT[passantPawn][from.rank][to.file];
+		} else if (action.isCastle()) {
+			// Castling, the rook ends up next to the king
+			constexpr Piece rook = Us | ROOK;
+			psqtDelta += PSQT[rook][from.rank][(from.file + to.file) / 2] -
+				PSQT[rook][from.rank][to.file < from.file ? 0 : 7];
+		}
 
-void genPawnMoves(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	const std::unique_ptr<Coordinate>& mustKill,
-	const std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions,
-	std::vector<ChildNode>& children
-)
-{
-	int direction = pawnDirection(c);
-	Coordinate target;
-	auto pinnedElement = pinnedPositions.find(pos);
-	bool isPinned = pinnedElement != pinnedPositions.end();
+		score += pawnDirection(Us) * psqtDelta;
 
-	for (int side=-1; side<=1; side+=2) {
-		target = pos + Coordinate{direction, side};
-		if (!target.isValid())
-			continue;
+		actions.push_back({action, score, 0});
+	}
 
-		if (isPinned && !pinnedElement->second.contains(target))
-			continue;
+	template <Color Us>
+	inline void insertAction(Gamestate const* statep, const Coordinate& from, const Coordinate& to, std::vector<ScoredAction>& actions, unsigned int flags=Action::NORMAL)
+	{
+		insertAction<Us>(statep, from, to, flags, 0, actions);
+	}
 
-		Piece targetPiece = statep->board.get(target);
+	template <Color Us>
+	void insertPromotions(Gamestate const* statep, const Coordinate& from, const Coordinate& to, float captureGain, const GainRange& gains, std::vector<ScoredAction>& actions)
+	{
+		for (Piece promotion=QUEEN; promotion>=KNIGHT; promotion--) {
+			if (!gains.contains(captureGain + materialValue[promotion] - materialValue[PAWN]))
+				continue;
+			// Search only queen promotion first
+			insertAction<Us>(statep, from, to, Action::promotionFlag(promotion), -(promotion == QUEEN ? 0 : materialValue[promotion]), actions);
+		}
+	}
 
-		if (pieceColor(targetPiece) == opponentColor(c) && targetPiece != NONE) {
+	template <Color Us>
+	void genPawnMoves(
+		Gamestate const* statep,
+		const Coordinate& pos,
+		const AttackInfo& info,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		constexpr int direction = pawnDirection(Us);
+		constexpr int startRank = Us == WHITE ? 1 : 6;
+		constexpr int promotionRank = Us == WHITE ? 7 : 0;
+		Bitboard allowed = info.legalTargets(pos.square());
+		Bitboard captures = pawnAttacks[Us == WHITE][pos.square()];
+
+		for (Bitboard targets = captures & statep->board.pieces(opponentColor(Us)) & allowed; targets; ) {
 			// Attack a piece
+			Coordinate target = Coordinate::fromSquare(popLsb(targets));
+			Piece targetPiece = statep->board.get(target);
 			assert(pieceType(targetPiece) != KING);
-			if (mustKill && target != *mustKill)
-				continue;
-			if (mustBlock && !mustBlock->contains(target))
-				continue;
+			float captureGain = materialValue[pieceType(targetPiece)];
 
-			if (target.rank == (c == WHITE ? 7 : 0)) {
+			if (target.rank == promotionRank)
 				// Also promote
-				for (Piece promotion=QUEEN; promotion>=KNIGHT; promotion--) {
-					// Search only queen promotion first
-					Gamestate* newstatep = insertChild(statep, pos, target, promotion, -(promotion == QUEEN ? 0 : materialValue[promotion]), children);
-					// Pawn move & capture
-					newstatep->rule50Ply = 0;
-				}
-			} else {
-				Gamestate* newstatep = insertChild(statep, pos, target, children);
-				// Pawn move & capture
-				newstatep->rule50Ply = 0;
-			}
-		} else if (target == statep->passantSquare) {
-			Coordinate pawnPos {statep->passantSquare - Delta{direction, 0}};
-			if (mustKill && pawnPos != *mustKill)
-				continue;
-			if (mustBlock && !mustBlock->contains(target))
-				continue;
-			// En passant
-			Gamestate* newstatep = insertChild(statep, pos, target, children);
-			newstatep->board.set(pawnPos, NONE);
-			// Pawn move & capture
-			newstatep->rule50Ply = 0;
+				insertPromotions<Us>(statep, pos, target, captureGain, gains, actions);
+			else if (gains.contains(captureGain))
+				insertAction<Us>(statep, pos, target, actions);
 		}
-	}
 
-	target = pos + Coordinate{direction, 0};
-	if (statep->board.get(target) == NONE) {
-		if (mustKill)
-			return;
+		if (
+			statep->passantSquare != NO_SQUARE &&
+			(captures & squareBB(statep->passantSquare)) &&
+			gains.contains(materialValue[PAWN]) &&
+			isLegalPassant(statep->board, pos.square(), statep->passantSquare, info)
+		) {
+			// En passant
+			insertAction<Us>(statep, pos, Coordinate::fromSquare(statep->passantSquare), actions, Action::PASSANT);
+		}
 
-		if (isPinned && !pinnedElement->second.contains(target))
-			// If moving 1 step breaks the pin, so will moving 2 steps
+		Coordinate target = pos + Coordinate{direction, 0};
+		if (statep->board.get(target) != NONE)
 			return;
 
 		// Move one step
-		if (!mustBlock || mustBlock->contains(target)) {
-			if (target.rank == (c == WHITE ? 7 : 0)) {
+		if (allowed & squareBB(target.square())) {
+			if (target.rank == promotionRank)
 				// Also promote
-				for (Piece promotion=QUEEN; promotion>=KNIGHT; promotion--) {
-					// Search only queen promotion first
-					Gamestate* newstatep = insertChild(statep, pos, target, promotion, -(promotion == QUEEN ? 0 : materialValue[promotion]), children);
-					// Pawn move
-					newstatep->rule50Ply = 0;
-				}
-			} else {
-				Gamestate* newstatep = insertChild(statep, pos, target, children);
-				// Pawn move
-				newstatep->rule50Ply = 0;
-			}
+				insertPromotions<Us>(statep, pos, target, 0, gains, actions);
+			else if (gains.contains(0))
+				insertAction<Us>(statep, pos, target, actions);
 		}
 
-		if (pos.rank == (c == WHITE ? 1 : 6)) {
+		if (pos.rank == startRank && gains.contains(0)) {
 			target = pos + Coordinate{2*direction, 0};
-			if (!mustBlock || mustBlock->contains(target)) {
-				if (statep->board.get(target) == NONE) {
-					// Move two steps
-					Gamestate* newstatep = insertChild(statep, pos, target, children);
-					newstatep->passantSquare = target - Coordinate{direction, 0};
-					// Pawn move
-					newstatep->rule50Ply = 0;
-				}
-			}
+			if (statep->board.get(target) == NONE && (allowed & squareBB(target.square())))
+				// Move two steps
+				insertAction<Us>(statep, pos, target, actions);
 		}
 	}
-}
 
-void genKnightMoves(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	const std::unique_ptr<Coordinate>& mustKill,
-	const std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions,
-	std::vector<ChildNode>& children
-)
-{
-	auto pinnedElement = pinnedPositions.find(pos);
-	bool isPinned = pinnedElement != pinnedPositions.end();
-	for (Coordinate offset : knightMoves) {
-		Coordinate target = pos + offset;
-		if (!target.isValid())
-			continue;
-		if (mustKill && target != *mustKill)
-			continue;
-		if (mustBlock && !mustBlock->contains(target))
-			continue;
-
-		if (isPinned && !pinnedElement->second.contains(target))
-			continue;
-
-		Piece targetPiece = statep->board.get(target);
-		bool emptySquare = targetPiece == NONE;
-		// Empty squares are black, but this does not matter in this case
-		if (emptySquare || pieceColor(targetPiece) != c) {
+	template <Color Us>
+	void genTargetMoves(
+		Gamestate const* statep,
+		const Coordinate& pos,
+		Bitboard targets,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		// Generate the moves of the piece on `pos` to the legal `targets`
+		targets &= ~statep->board.pieces(Us);
+		if (!gains.contains(0))
+			// Only captures
+			targets &= statep->board.occupancy();
+		else if (gains.max < materialValue[PAWN])
+			// Only moves to empty squares
+			targets &= statep->board.empty();
+
+		while (targets) {
+			Coordinate target = Coordinate::fromSquare(popLsb(targets));
+			Piece targetPiece = statep->board.get(target);
 			assert(pieceType(targetPiece) != KING);
-			// Move or attack
-			Gamestate* newstatep = insertChild(statep, pos, target, children);
-			if (!emptySquare)
-				// Capture
-				newstatep->rule50Ply = 0;
+			if (gains.contains(materialValue[pieceType(targetPiece)]))
+				// Move or capture
+				insertAction<Us>(statep, pos, target, actions);
 		}
 	}
 
-}
+	template <Color Us>
+	void genKingMoves(
+		Gamestate const* statep,
+		const Coordinate& pos,
+		const AttackInfo& info,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		genTargetMoves<Us>(statep, pos, kingAttacks[pos.square()] & ~info.attacked, gains, actions);
+
+		constexpr int homeRank = Us == WHITE ? 0 : 7;
+		if (info.checkers || !gains.contains(0) || pos != Coordinate{homeRank, 4})
+			return;
 
-void genBishopMoves(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	const std::unique_ptr<Coordinate>& mustKill,
-	const std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions,
-	std::vector<ChildNode>& children
-)
-{
-	auto pinnedElement = pinnedPositions.find(pos);
-	bool isPinned = pinnedElement != pinnedPositions.end();
-
-	if (mustKill && !(*mustKill - pos).isDiagonal())
-		return;
-	if (isPinned && !pinnedElement->second.step.isDiagonal())
-		return;
-
-	for (int rankDirection=-1; rankDirection<=1; rankDirection+=2) {
-		for (int fileDirection=-1; fileDirection<=1; fileDirection+=2) {
-			Delta step {rankDirection, fileDirection};
-			for (Coordinate target {pos.rank + step.rank, pos.file + step.file}; target.isValid(); target += step) {
-				bool cantMove = (mustKill && target != *mustKill) ||
-					(mustBlock && !mustBlock->contains(target)) ||
-					(isPinned && !pinnedElement->second.contains(target));
-
-				Piece targetPiece = statep->board.get(target);
-				// Empty squares are black, but this does not matter in this case
-				if (targetPiece == NONE) {
-					if (cantMove)
-						continue;
-					// Move
-					insertChild(statep, pos, target, children);
-				} else if (pieceColor(targetPiece) != c) {
-					assert(pieceType(targetPiece) != KING);
-					if (!cantMove) {
-						// Capture
-						Gamestate* newstatep = insertChild(statep, pos, target, children);
-						newstatep->rule50Ply = 0;
-					}
-
-					// Blocked by enemy piece, can't move further in this direction
-					break;
-				} else {
-					// Blocked by friendly piece, can't move further in this direction
-					break;
-				}
-			}
+		// The king may not pass or land on an attacked square, the rook may
+		auto isFree = [&](int file, bool mayBeAttacked) {
+			Coordinate square {homeRank, file};
+			return statep->board.get(square) == NONE &&
+				(mayBeAttacked || !(info.attacked & squareBB(square.square())));
+		};
+
+		if ((statep->castling & kingsideRight(Us)) && isFree(5, false) && isFree(6, false))
+			insertAction<Us>(statep, pos, {homeRank, 6}, actions, Action::CASTLE);
+		if ((statep->castling & queensideRight(Us)) && isFree(3, false) && isFree(2, false) && isFree(1, true))
+			insertAction<Us>(statep, pos, {homeRank, 2}, actions, Action::CASTLE);
+	}
+
+	MoveGeneration moveGeneration = MoveGeneration::LEGAL;
+
+	void setMoveGeneration(MoveGeneration generation)
+	{
+		moveGeneration = generation;
+	}
+
+	MoveGeneration getMoveGeneration()
+	{
+		return moveGeneration;
+	}
+
+	void findChecks(Gamestate const* statep, AttackInfo& info, MoveGeneration generation)
+	{
+		if (generation == MoveGeneration::PSEUDO_LEGAL) {
+			// Pins and attacked squares are left to isLegal
+			getChecks(statep->board, statep->whiteToMove ? WHITE : BLACK, info);
+			return;
 		}
+
+		// Shared with game status detection of the same gamestate
+		info = analyseAttacks(statep);
 	}
-}
 
-void setCastle(Gamestate* statep, Color c, const Coordinate& pos)
-{
-	// Assumes the rook is on its starting rank
-	assert(pos.rank == (c == WHITE ? 0 : 7));
-	// Unset queen-/kingside castling-rights if departing from a or h
-	switch (pos.file) {
-		case 0:
-			(c == WHITE ? statep->whiteCastle : statep->blackCastle).queenside = false;
-			break;
-		case 7:
-			(c == WHITE ? statep->whiteCastle : statep->blackCastle).kingside = false;
-			break;
-		default:
-			break;
+	bool isLegal(Gamestate const* statep, const Action& action, const AttackInfo& info, MoveGeneration generation)
+	{
+		// Whether a move generated with the checks in `info` doesn't leave the
+		// king in check. Moves of other pieces already block or take a single
+		// checker, and en passant is checked when generated
+		if (generation == MoveGeneration::LEGAL)
+			return true;
+
+		const Board& b = statep->board;
+		Bitboard opponents = b.pieces(statep->whiteToMove ? BLACK : WHITE);
+		unsigned int from = action.fromSquare();
+		unsigned int to = action.toSquare();
+		Bitboard occupied = b.occupancy() & ~squareBB(from);
+
+		if (action.isCastle())
+			// The king isn't in check, and may not pass or land on an attacked square
+			return !(attackersTo(b, (from + to) / 2, occupied) & opponents) &&
+				!(attackersTo(b, to, occupied) & opponents);
+
+		if (from == info.kingSquare)
+			// Sliders see through the king, so it can't step back along the line of a check
+			return !(attackersTo(b, to, occupied) & opponents);
+
+		Bitboard line = lineThrough[info.kingSquare][from];
+		if (action.isPassant() || !line || (line & squareBB(to)))
+			// Can't uncover a check
+			return true;
+
+		// Leaving the line through the king may uncover a slider, unless it is taken
+		return !(attackersTo(b, info.kingSquare, occupied | squareBB(to)) & opponents & ~squareBB(to));
 	}
-}
 
-void genRookMoves(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	const std::unique_ptr<Coordinate>& mustKill,
-	const std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions,
-	std::vector<ChildNode>& children
-)
-{
-	auto pinnedElement = pinnedPositions.find(pos);
-	bool isPinned = pinnedElement != pinnedPositions.end();
-
-	int homeRank = c == WHITE ? 0 : 7;
-
-	if (mustKill && !(*mustKill - pos).isStraight())
-		return;
-	if (isPinned && !pinnedElement->second.step.isStraight())
-		return;
-
-	// Whether to move in rank or file
-	for (int rank=0; rank<=1; rank++) {
-		for (int direction=-1; direction<=1; direction+=2) {
-			Delta step {rank*direction, (!rank)*direction};
-			for (Coordinate target {pos.rank + step.rank, pos.file + step.file}; target.isValid(); target += step) {
-				bool cantMove = (mustKill && target != *mustKill) ||
-					(mustBlock && !mustBlock->contains(target)) ||
-					(isPinned && !pinnedElement->second.contains(target));
-
-				Piece targetPiece = statep->board.get(target);
-				// Empty squares are black, but this does not matter in this case
-				if (targetPiece == NONE) {
-					if (cantMove)
-						continue;
-					// Move
-					Gamestate* newstatep = insertChild(statep, pos, target, children);
-					if (pos.rank == homeRank)
-						// Unset castling avaliability
-						setCastle(newstatep, c, pos);
-
-				} else if (pieceColor(targetPiece) != c) {
-					assert(pieceType(targetPiece) != KING);
-					if (!cantMove) {
-						// Capture
-						Gamestate* newstatep = insertChild(statep, pos, target, children);
-						newstatep->rule50Ply = 0;
-
-						if (pos.rank == homeRank)
-							// Unset castling avaliability
-							setCastle(newstatep, c, pos);
-					}
-
-					// Blocked by enemy piece, can't move further in this direction
-					break;
-				} else {
-					// Blocked by friendly piece, can't move further in this direction
-					break;
-				}
-			}
+	template <Color Us, PieceType Type>
+	void genTypeMoves(
+		Gamestate const* statep,
+		const AttackInfo& info,
+		Bitboard pieces,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		// Generate the legal moves of the pieces on `pieces`, all of type `Type`
+		Bitboard occupied = statep->board.occupancy();
+
+		while (pieces) {
+			unsigned int square = popLsb(pieces);
+			Coordinate pos = Coordinate::fromSquare(square);
+
+			if constexpr (Type == PAWN)
+				genPawnMoves<Us>(statep, pos, info, gains, actions);
+			else if constexpr (Type == KNIGHT)
+				genTargetMoves<Us>(statep, pos, knightAttacks[square] & info.legalTargets(square), gains, actions);
+			else if constexpr (Type == BISHOP)
+				genTargetMoves<Us>(statep, pos, bishopAttacks(square, occupied) & info.legalTargets(square), gains, actions);
+			else if constexpr (Type == ROOK)
+				genTargetMoves<Us>(statep, pos, rookAttacks(square, occupied) & info.legalTargets(square), gains, actions);
+			else if constexpr (Type == QUEEN)
+				genTargetMoves<Us>(statep, pos, queenAttacks(square, occupied) & info.legalTargets(square), gains, actions);
+			else
+				genKingMoves<Us>(statep, pos, info, gains, actions);
 		}
 	}
-}
 
-void genQueenMoves(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	const std::unique_ptr<Coordinate>& mustKill,
-	const std::unique_ptr<Line>& mustBlock,
-	const std::map<Coordinate, Line>& pinnedPositions,
-	std::vector<ChildNode>& children
-)
-{
-	genBishopMoves(statep, c, pos, mustKill, mustBlock, pinnedPositions, children);
-	genRookMoves(statep, c, pos, mustKill, mustBlock, pinnedPositions, children);
-}
+	template <Color Us>
+	void genPieceMoves(
+		Gamestate const* statep,
+		const AttackInfo& info,
+		const Coordinate& pos,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		// Generate the legal moves of the piece on `pos`, if it is one of the player to move
+		Piece p = statep->board.get(pos);
+		if (p == NONE || pieceColor(p) != Us)
+			return;
 
-void genKingMoves(
-	Gamestate const* statep,
-	Color c,
-	const Coordinate& pos,
-	const std::array<bool, 10>& attackedSquares,
-	bool inCheck,
-	std::vector<ChildNode>& children
-)
-{
-	const Castle& myCastle = (c == WHITE ? statep->whiteCastle : statep->blackCastle);
-	bool mayCastle = !inCheck &&
-		pos.file == 4 &&
-		(pos.rank == (c == WHITE ? 0 : 7));
-
-	for (auto it = kingMoveOrder.begin(); it != kingMoveOrder.end(); it++) {
-		Coordinate target = pos + it->first;
-		if (!target.isValid())
-			continue;
-
-		if (attackedSquares[it->second])
-			// Square is attacked by the opponent
-			continue;
-
-		Piece targetPiece = statep->board.get(target);
-
-		if (std::abs(it->first.file) == 2) {
-			// Castle
-			if (it->first.file < 0) {
-				// Queenside
-				if (
-					mayCastle &&
-					myCastle.queenside &&
-					statep->board.get(target) == NONE &&
-					statep->board.get(target + Coordinate{0, 1}) == NONE &&
-					statep->board.get(target - Coordinate{0, 1}) == NONE &&
-					!attackedSquares[kingMoveOrder.find({0, -1})->second]
-				) {
-					Gamestate* newstatep = insertChild(statep, pos, target, children);
-					// Move the rook
-					newstatep->board.move({(c == WHITE ? 0 : 7), 0}, target + Coordinate{0, 1});
-
-					if (c == WHITE)
-						newstatep->whiteCastle = {false, false};
-					else
-						newstatep->blackCastle = {false, false};
-				}
+		Bitboard piece = squareBB(pos.square());
 
-			} else {
-				// Kingside
-				if (
-					mayCastle &&
-					myCastle.kingside &&
-					statep->board.get(target) == NONE &&
-					statep->board.get(target + Coordinate{0, -1}) == NONE &&
-					!attackedSquares[kingMoveOrder.find({0, 1})->second]
-				) {
-					Gamestate* newstatep = insertChild(statep, pos, target, children);
-					// Move the rook
-					newstatep->board.move({(c == WHITE ? 0 : 7), 7}, target - Coordinate{0, 1});
-
-					if (c == WHITE)
-						newstatep->whiteCastle = {false, false};
-					else
-						newstatep->blackCastle = {false, false};
-				}
-			}
-		// Empty squares are black, but this does not matter in this case
-		} else if (targetPiece == NONE || pieceColor(targetPiece) != c) {
-			// Move or attack
-			Gamestate* newstatep = insertChild(statep, pos, target, children);
-
-			// Can't castle after moving king
-			if (c == WHITE)
-				newstatep->whiteCastle = {false, false};
-			else
-				newstatep->blackCastle = {false, false};
+		switch (pieceType(p)) {
+			case PAWN:
+				genTypeMoves<Us, PAWN>(statep, info, piece, gains, actions);
+				break;
+			case KNIGHT:
+				genTypeMoves<Us, KNIGHT>(statep, info, piece, gains, actions);
+				break;
+			case BISHOP:
+				genTypeMoves<Us, BISHOP>(statep, info, piece, gains, actions);
+				break;
+			case ROOK:
+				genTypeMoves<Us, ROOK>(statep, info, piece, gains, actions);
+				break;
+			case QUEEN:
+				genTypeMoves<Us, QUEEN>(statep, info, piece, gains, actions);
+				break;
+			case KING:
+				genTypeMoves<Us, KING>(statep, info, piece, gains, actions);
+				break;
+			default:
+				throw std::invalid_argument("Invalid piece on board");
+				break;
+		}
+	}
+
+	void genPieceMoves(
+		Gamestate const* statep,
+		const AttackInfo& info,
+		const Coordinate& pos,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		if (statep->whiteToMove)
+			genPieceMoves<WHITE>(statep, info, pos, gains, actions);
+		else
+			genPieceMoves<BLACK>(statep, info, pos, gains, actions);
+	}
 
-			if (targetPiece != NONE)
-				// Capture
-				newstatep->rule50Ply = 0;
+	void sortActions(std::vector<ScoredAction>& actions, size_t first=0)
+	{
+		// Search the moves with largest score first, equal moves in generation order
+		// Insertion sort is stable without std::stable_sort's temporary buffer
+		for (size_t i=first+1; i<actions.size(); i++) {
+			ScoredAction action = actions[i];
+			size_t hole = i;
+			for (; hole > first && action > actions[hole - 1]; hole--)
+				actions[hole] = actions[hole - 1];
+			actions[hole] = action;
 		}
 	}
 
-}
+	template <Color Us>
+	void genMoves(
+		Gamestate const* statep,
+		const AttackInfo& info,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		// The bitboards are the piece lists, so only the squares of the pieces
+		// of the player to move are visited
+		const Board& b = statep->board;
+		if (info.amtChecks() < 2) {
+			genTypeMoves<Us, PAWN>(statep, info, b.pieces(Us, PAWN), gains, actions);
+			genTypeMoves<Us, KNIGHT>(statep, info, b.pieces(Us, KNIGHT), gains, actions);
+			genTypeMoves<Us, BISHOP>(statep, info, b.pieces(Us, BISHOP), gains, actions);
+			genTypeMoves<Us, ROOK>(statep, info, b.pieces(Us, ROOK), gains, actions);
+			genTypeMoves<Us, QUEEN>(statep, info, b.pieces(Us, QUEEN), gains, actions);
+		}
+		// Only king-moves can get out of double check
+		genTypeMoves<Us, KING>(statep, info, b.pieces(Us, KING), gains, actions);
+	}
 
-void genChildren(
-	Gamestate const* statep,
-	std::vector<Gamestate*>& gamestates,
-	std::vector<Action*>& actions
-)
-{
-	// Both in stalemate and in mate no moves should be generated
-	if (statep->rule50Ply >= 150)
-		// Forced game end after 75 moves w/o captures/pawn moves
-		return;
+	void genMoves(
+		Gamestate const* statep,
+		const AttackInfo& info,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		// Append the legal moves with a gain in `gains` to `actions`, best first
+		// Both in stalemate and in mate no moves should be generated
+		if (statep->rule50Ply >= 150)
+			// Forced game end after 75 moves w/o captures/pawn moves
+			return;
 
-	Color toMove = statep->whiteToMove ? WHITE : BLACK;
-	Coordinate kingPos = findKing(statep->board, toMove);
+		size_t first = actions.size();
 
-	std::array<bool, 10> attackedSquares = {
-		false, false, false, false, false, false, false, false, false, false
-	};
-	std::unique_ptr<Coordinate> mustKill;
-	std::unique_ptr<Line> mustBlock;
-	std::map<Coordinate, Line> pinnedPositions;
-
-
-	// Amount of checks on the king
-	unsigned int amtChecks = getAttacks(
-		// Parameters
-		statep->board,
-		kingPos,
-		toMove,
-		// Output
-		attackedSquares,
-		mustKill,
-		mustBlock,
-		pinnedPositions
-	);
-
-	std::vector<ChildNode> children;
-
-	// 2+ attackers -> only king-moves can get out of check
-	if (amtChecks >= 2) {
-		genKingMoves(statep, toMove, kingPos, attackedSquares, true, children);
-		return;
+		if (statep->whiteToMove)
+			genMoves<WHITE>(statep, info, gains, actions);
+		else
+			genMoves<BLACK>(statep, info, gains, actions);
+
+		sortActions(actions, first);
+	}
+
+	void genCaptures(
+		Gamestate const* statep,
+		const AttackInfo& info,
+		const GainRange& gains,
+		std::vector<ScoredAction>& actions
+	)
+	{
+		// Like genMoves for captures and promotions, but the exchange on the
+		// target square of each capture is played out once, so the captures
+		// that win the most material are searched first
+		if (statep->rule50Ply >= 150)
+			return;
+
+		size_t first = actions.size();
+
+		if (statep->whiteToMove)
+			genMoves<WHITE>(statep, info, gains, actions);
+		else
+			genMoves<BLACK>(statep, info, gains, actions);
+
+		for (size_t i=first; i<actions.size(); i++) {
+			ScoredAction& scored = actions[i];
+			const Action& action = scored.action;
+			PieceType captured = action.isPassant() ? PAWN : pieceType(statep->board.get(action.to()));
+			if (captured == NONE)
+				// Promotion without a capture
+				continue;
+
+			scored.see = see(statep->board, action.fromSquare(), action.toSquare());
+			// The captured piece is already counted by the change in PSQT score
+			scored.score += scored.see - materialValue[captured];
+		}
+
+		sortActions(actions, first);
+	}
+
+	void genLegalActions(Gamestate const* statep, std::vector<ScoredAction>& actions)
+	{
+		AttackInfo info;
+		findChecks(statep, info, moveGeneration);
+
+		size_t first = actions.size();
+		if (statep->whiteToMove)
+			genMoves<WHITE>(statep, info, ALL_MOVES, actions);
+		else
+			genMoves<BLACK>(statep, info, ALL_MOVES, actions);
+
+		auto illegal = [statep, &info](const ScoredAction& action) {
+			return !isLegal(statep, action.action, info, moveGeneration);
+		};
+		if (moveGeneration == MoveGeneration::PSEUDO_LEGAL)
+			actions.erase(std::remove_if(actions.begin() + first, actions.end(), illegal), actions.end());
 	}
 
-	for (int rank=0; rank<8; rank++) {
-		for (int file=0; file<8; file++) {
-			Piece p = statep->board.get({rank, file});
-			if (p != NONE && pieceColor(p) == toMove) {
-				switch (pieceType(p)) {
-					case PAWN:
-						genPawnMoves(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions, children);
+	void Chess::genChildren(
+		Gamestate const* statep,
+		std::vector<Gamestate*>& gamestates,
+		std::vector<Action*>& actions
+	)
+	{
+		AttackInfo info;
+		findChecks(statep, info, moveGeneration);
+
+		std::vector<ScoredAction> moves;
+		genMoves(statep, info, ALL_MOVES, moves);
+
+		for (const ScoredAction& move : moves) {
+			if (!isLegal(statep, move.action, info, moveGeneration))
+				continue;
+
+			Gamestate* newstatep = new Gamestate{*statep};
+			Undo undo;
+			chess::makeMove(*newstatep, move.action, undo);
+
+			gamestates.push_back(newstatep);
+			actions.push_back(new Action{move.action});
+		}
+	}
+
+	namespace
+	{
+		// No chess position has more legal moves
+		constexpr unsigned int MAX_MOVES = 218;
+
+		enum class Stage : uint8_t
+		{
+			HASH_ACTION,
+			GEN_CAPTURES,
+			WINNING_CAPTURES,
+			KILLERS,
+			GEN_QUIETS,
+			QUIETS,
+			LOSING_CAPTURES,
+			CAPTURES, /* Quiescence search */
+			DONE
+		};
+
+		// Staged move generation: each stage is only generated once the
+		// previous ones are used up, so after a cutoff the rest never is
+		struct MovePicker
+		{
+			Gamestate const* statep;
+			MoveGeneration generation;
+			AttackInfo info;
+
+			Stage stage;
+			unsigned int index;
+			// Whether all legal actions are generated, not just captures
+			bool allActions;
+			unsigned int amtReturned;
+
+			uint16_t hashAction;
+			uint16_t killers[KILLER_SLOTS];
+			// Material the losing captures may lose, see initActions
+			float maxLoss;
+
+			// Actions of the current stage
+			std::vector<ScoredAction> actions;
+			// Captures that may lose material, searched after the quiet actions
+			std::vector<ScoredAction> losingCaptures;
+			// Hash and killer actions, skipped when generated again by later stages
+			std::vector<ScoredAction> picked;
+			// Moves of a single piece, to check the hash and killer actions are legal
+			std::vector<ScoredAction> pieceMoves;
+		};
+
+		// Move pickers of the in-place interface, per thread and indexed by ply
+		// Each ply keeps its storage between searches, so once every ply
+		// reached has been used, generating actions doesn't allocate
+		thread_local std::vector<MovePicker> pickers;
+
+		MovePicker& initPicker(Gamestate const* statep, MoveGeneration generation, unsigned int ply)
+		{
+			while (ply >= pickers.size()) {
+				pickers.emplace_back();
+				MovePicker& picker = pickers.back();
+				picker.actions.reserve(MAX_MOVES);
+				picker.losingCaptures.reserve(MAX_MOVES);
+				picker.picked.reserve(1 + KILLER_SLOTS);
+				picker.pieceMoves.reserve(MAX_MOVES);
+			}
+
+			MovePicker& picker = pickers[ply];
+			picker.statep = statep;
+			picker.generation = generation;
+			picker.index = 0;
+			picker.amtReturned = 0;
+			picker.actions.clear();
+			picker.losingCaptures.clear();
+			picker.picked.clear();
+			findChecks(statep, picker.info, generation);
+			return picker;
+		}
+
+		bool isPicked(const MovePicker& picker, uint16_t key)
+		{
+			for (const ScoredAction& action : picker.picked)
+				if (Chess::actionKey(&action.action) == key)
+					return true;
+			return false;
+		}
+
+		bool pickAction(MovePicker& picker, uint16_t key, const GainRange& gains)
+		{
+			// Pick the action with the given key if it is legal
+			// Only the moves of the piece it moves are generated
+			if (key == NO_ACTION || isPicked(picker, key))
+				return false;
+
+			Coordinate from {(key & 0x3f) / 8, key & 0x7};
+
+			picker.pieceMoves.clear();
+			genPieceMoves(picker.statep, picker.info, from, gains, picker.pieceMoves);
+
+			for (const ScoredAction& action : picker.pieceMoves) {
+				if (Chess::actionKey(&action.action) == key) {
+					picker.picked.push_back(action);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool isWinning(const ScoredAction& action)
+		{
+			// Whether the capture or promotion from genCaptures doesn't lose material
+			if (action.action.isPromotion())
+				// Underpromotions are almost never best
+				return action.action.promotionPiece() == QUEEN;
+			return action.see >= 0;
+		}
+
+		ScoredAction const* nextFrom(MovePicker& picker, const std::vector<ScoredAction>& actions)
+		{
+			// Next action of the list that wasn't picked by an earlier stage
+			while (picker.index < actions.size()) {
+				const ScoredAction& action = actions[picker.index++];
+				if (!isPicked(picker, Chess::actionKey(&action.action)))
+					return &action;
+			}
+			return nullptr;
+		}
+	}
+
+	void Chess::initActions(Gamestate const* statep, uint16_t hashAction, float maxLoss, unsigned int ply)
+	{
+		MovePicker& picker = initPicker(statep, moveGeneration, ply);
+		picker.maxLoss = maxLoss;
+		picker.stage = statep->rule50Ply >= 150 ? Stage::DONE : Stage::HASH_ACTION;
+		// Having no moves after the 75 move rule doesn't mean mate or stalemate
+		picker.allActions = picker.stage != Stage::DONE;
+		picker.hashAction = hashAction;
+		for (unsigned int slot=0; slot<KILLER_SLOTS; slot++)
+			picker.killers[slot] = killerAction(ply, slot);
+	}
+
+	void Chess::initCaptures(Gamestate const* statep, float minGain, unsigned int ply)
+	{
+		// Checks and check evasions are not generated, positions in check are
+		// evaluated as they are unless they are mate
+		// Evaluating the gamestate already found its pins and attacked squares,
+		// so only legal captures are generated
+		MovePicker& picker = initPicker(statep, MoveGeneration::LEGAL, ply);
+		genCaptures(statep, picker.info, {std::max(minGain, CAPTURE_MOVES.min), INFINITY}, picker.actions);
+
+		// Captures that lose material can't improve on standing pat
+		auto losing = [](const ScoredAction& action) {
+			return !action.action.isPromotion() && action.see < 0;
+		};
+		picker.actions.erase(std::remove_if(picker.actions.begin(), picker.actions.end(), losing), picker.actions.end());
+
+		picker.stage = Stage::CAPTURES;
+		picker.allActions = false;
+	}
+
+	namespace
+	{
+		Action const* pickNext(MovePicker& picker)
+		{
+			ScoredAction const* actionp = nullptr;
+
+			while (true) {
+				switch (picker.stage) {
+					case Stage::HASH_ACTION:
+						picker.stage = Stage::GEN_CAPTURES;
+						if (pickAction(picker, picker.hashAction, ALL_MOVES))
+							return &picker.picked.back().action;
 						break;
-					case KNIGHT:
-						genKnightMoves(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions, children);
+					case Stage::GEN_CAPTURES:
+						genCaptures(picker.statep, picker.info, CAPTURE_MOVES, picker.actions);
+
+						// Keep the winning captures in order, and set the others aside
+						{
+							size_t winning = 0;
+							for (size_t i=0; i<picker.actions.size(); i++) {
+								if (isWinning(picker.actions[i]))
+									picker.actions[winning++] = picker.actions[i];
+								else
+									picker.losingCaptures.push_back(picker.actions[i]);
+							}
+							picker.actions.erase(picker.actions.begin() + winning, picker.actions.end());
+						}
+
+						picker.index = 0;
+						picker.stage = Stage::WINNING_CAPTURES;
 						break;
-					case BISHOP:
-						genBishopMoves(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions, children);
+					case Stage::WINNING_CAPTURES:
+						if ((actionp = nextFrom(picker, picker.actions)))
+							return &actionp->action;
+						picker.index = 0;
+						picker.stage = Stage::KILLERS;
 						break;
-					case ROOK:
-						genRookMoves(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions, children);
+					case Stage::KILLERS:
+						while (picker.index < KILLER_SLOTS) {
+							if (pickAction(picker, picker.killers[picker.index++], QUIET_MOVES))
+								return &picker.picked.back().action;
+						}
+						picker.stage = Stage::GEN_QUIETS;
 						break;
-					case QUEEN:
-						genQueenMoves(statep, toMove, {rank, file}, mustKill, mustBlock, pinnedPositions, children);
+					case Stage::GEN_QUIETS:
+						picker.actions.clear();
+						genMoves(picker.statep, picker.info, QUIET_MOVES, picker.actions);
+						picker.index = 0;
+						picker.stage = Stage::QUIETS;
 						break;
-					case KING:
-						genKingMoves(statep, toMove, kingPos, attackedSquares, amtChecks != 0, children);
+					case Stage::QUIETS:
+						if ((actionp = nextFrom(picker, picker.actions)))
+							return &actionp->action;
+						picker.index = 0;
+						picker.stage = Stage::LOSING_CAPTURES;
 						break;
-					default:
-						throw std::invalid_argument("Invalid piece on board");
+					case Stage::LOSING_CAPTURES:
+						while ((actionp = nextFrom(picker, picker.losingCaptures))) {
+							// Captures losing more than maxLoss are skipped, unless
+							// in check or no other action was found
+							if (
+								actionp->action.isPromotion() || picker.amtReturned == 0 || picker.info.checkers ||
+								actionp->see >= -picker.maxLoss
+							)
+								return &actionp->action;
+						}
+						picker.stage = Stage::DONE;
 						break;
+					case Stage::CAPTURES:
+						if ((actionp = nextFrom(picker, picker.actions)))
+							return &actionp->action;
+						picker.stage = Stage::DONE;
+						break;
+					case Stage::DONE:
+						return nullptr;
 				}
 			}
 		}
 	}
 
-	// Search the moves with largest score first
-	for (auto child = children.rbegin(); child != children.rend(); child++) {
-		actions.push_back(child->action);
-		gamestates.push_back(child->gamestate);
+	Action const* Chess::nextAction(unsigned int ply)
+	{
+		MovePicker& picker = pickers[ply];
+		Action const* actionp;
+		do
+			actionp = pickNext(picker);
+		while (actionp && !isLegal(picker.statep, *actionp, picker.info, picker.generation));
+
+		if (actionp)
+			picker.amtReturned++;
+		else if (picker.allActions && picker.amtReturned == 0)
+			// Mate or stalemate, so evaluating the gamestate doesn't look for moves again
+			reportNoMoves(picker.statep);
+
+		return actionp;
 	}
-
-	return;
 }
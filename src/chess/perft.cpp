@@ -0,0 +1,154 @@
+#include "perft.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace chess
+{
+	namespace
+	{
+		// Counts below gamestates, by key and remaining depth, shared by all threads
+		// Lockless like the transposition table: each slot stores `key ^ data`
+		// next to `data`, so a slot torn by two threads writing it fails the key check
+		class PerftHash
+		{
+			struct Slot
+			{
+				std::atomic<uint64_t> check;
+				std::atomic<uint64_t> data; /* nodes:56 | depth:8 */
+			};
+
+			std::unique_ptr<Slot[]> slots;
+			size_t mask;
+
+		public:
+			// Size is rounded down to a power of two slots
+			PerftHash(size_t megabytes)
+			{
+				size_t amtSlots = 1;
+				while (amtSlots * 2 * sizeof(Slot) <= megabytes << 20)
+					amtSlots *= 2;
+
+				slots.reset(new Slot[amtSlots]);
+				mask = amtSlots - 1;
+				for (size_t i=0; i<amtSlots; i++) {
+					// Depth 0 is never looked up
+					slots[i].check.store(0, std::memory_order_relaxed);
+					slots[i].data.store(0, std::memory_order_relaxed);
+				}
+			}
+
+			bool probe(uint64_t key, unsigned int depth, uint64_t& nodes) const
+			{
+				const Slot& slot = slots[key & mask];
+				uint64_t data = slot.data.load(std::memory_order_relaxed);
+				if ((slot.check.load(std::memory_order_relaxed) ^ data) != key || (data & 0xff) != depth)
+					return false;
+				nodes = data >> 8;
+				return true;
+			}
+
+			void store(uint64_t key, unsigned int depth, uint64_t nodes)
+			{
+				// Always replace, deeper counts are found again from their parents
+				Slot& slot = slots[key & mask];
+				uint64_t data = nodes << 8 | depth;
+				slot.data.store(data, std::memory_order_relaxed);
+				slot.check.store(key ^ data, std::memory_order_relaxed);
+			}
+		};
+
+		// Counts leaf nodes on a single thread, playing the actions in place
+		struct PerftCounter
+		{
+			PerftHash* hash;
+			// Actions of the gamestate being counted at each remaining depth
+			std::vector<std::vector<ScoredAction>> actions;
+
+			uint64_t count(Gamestate& state, unsigned int depth)
+			{
+				if (depth == 0)
+					return 1;
+
+				uint64_t key = 0;
+				uint64_t nodes = 0;
+				if (hash && depth > 1) {
+					key = Chess::hashState(&state);
+					if (hash->probe(key, depth, nodes))
+						return nodes;
+				}
+
+				std::vector<ScoredAction>& list = actions[depth];
+				list.clear();
+				genLegalActions(&state, list);
+
+				// Bulk counting: the actions one ply above the leaves are counted,
+				// not played
+				if (depth == 1)
+					return list.size();
+
+				Undo undo;
+				for (const ScoredAction& action : list) {
+					makeMove(state, action.action, undo);
+					nodes += count(state, depth - 1);
+					unmakeMove(state, action.action, undo);
+				}
+
+				if (hash)
+					hash->store(key, depth, nodes);
+				return nodes;
+			}
+		};
+	}
+
+	std::vector<PerftCount> divide(const Gamestate& state, unsigned int depth, const PerftOptions& options)
+	{
+		std::vector<ScoredAction> rootActions;
+		genLegalActions(&state, rootActions);
+
+		std::vector<PerftCount> counts;
+		for (const ScoredAction& action : rootActions)
+			counts.push_back({action.action, 0});
+
+		if (depth == 0)
+			return counts;
+
+		std::unique_ptr<PerftHash> hash;
+		if (options.hashMegabytes)
+			hash = std::make_unique<PerftHash>(options.hashMegabytes);
+
+		// Each thread counts the next action of the root no thread has taken yet,
+		// so threads that get small subtrees take more of them
+		std::atomic<size_t> next {0};
+		auto countActions = [&]() {
+			PerftCounter counter {hash.get(), std::vector<std::vector<ScoredAction>>(depth)};
+			for (size_t i; (i = next.fetch_add(1)) < counts.size(); ) {
+				Gamestate child {state};
+				Undo undo;
+				makeMove(child, counts[i].action, undo);
+				counts[i].nodes = counter.count(child, depth - 1);
+			}
+		};
+
+		std::vector<std::thread> helpers;
+		for (unsigned int i=1; i<options.threads; i++)
+			helpers.emplace_back(countActions);
+		countActions();
+		for (std::thread& helper : helpers)
+			helper.join();
+
+		return counts;
+	}
+
+	uint64_t perft(const Gamestate& state, unsigned int depth, const PerftOptions& options)
+	{
+		if (depth == 0)
+			return 1;
+
+		uint64_t nodes = 0;
+		for (const PerftCount& count : divide(state, depth, options))
+			nodes += count.nodes;
+		return nodes;
+	}
+}
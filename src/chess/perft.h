@@ -0,0 +1,38 @@
+#ifndef CHESS_PERFT_H_INCLUDED
+#define CHESS_PERFT_H_INCLUDED
+
+#include "states.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace chess
+{
+	// Perft counts the sequences of legal moves of a given length. Compared to
+	// known counts it checks move generation, and timed it benchmarks it
+
+	struct PerftOptions
+	{
+		// The actions of the root are split between this many threads
+		unsigned int threads = 1;
+		// Size of the table of counts below gamestates, shared by the threads,
+		// or 0 to count every subtree
+		size_t hashMegabytes = 0;
+	};
+
+	struct PerftCount
+	{
+		Action action;
+		uint64_t nodes;
+	};
+
+	// Amount of leaf nodes `depth` plies below the gamestate
+	uint64_t perft(const Gamestate& state, unsigned int depth, const PerftOptions& options={});
+
+	// Amount of leaf nodes below each action of the gamestate, `depth` plies
+	// below the gamestate, in generation order
+	std::vector<PerftCount> divide(const Gamestate& state, unsigned int depth, const PerftOptions& options={});
+}
+
+#endif
@@ -1,11 +1,26 @@
 #include "pieces.h"
 
-Piece symbolToPiece(char symbol)
+#include <array>
+
+namespace chess
 {
-	// Could've made a switch, but this is rarely used
-	for (Piece p=0; p<=15; p++)
-		if (pieceToSymbol[p] == symbol)
-			return p;
-	return UNKNOWN;
-}
+	namespace
+	{
+		// Inverse of pieceToSymbol, indexed by the symbol, used when reading FENs
+		constexpr std::array<Piece, 256> symbolPieces = [] {
+			std::array<Piece, 256> pieces {};
+			for (Piece& piece : pieces)
+				piece = UNKNOWN;
+			// The first piece with a symbol is written last
+			for (int p=15; p>=0; p--)
+				pieces[static_cast<unsigned char>(pieceToSymbol[p])] = p;
+			return pieces;
+		}();
+	}
 
+	Piece symbolToPiece(char symbol)
+	{
+		return symbolPieces[static_cast<unsigned char>(symbol)];
+	}
+
+}
@@ -1,146 +1,164 @@
 // Based on https://www.chessprogramming.org/Simplified_Evaluation_Function
 
-inline constexpr float PSQT[16][8][8] = {
-	{ },
-	{ // Black pawn
-		{   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0 },
-		{  -1.5,  -1.5,  -1.5,  -1.5,  -1.5,  -1.5,  -1.5,  -1.5 },
-		{  -1.1,  -1.1,  -1.2,  -1.3,  -1.3,  -1.2,  -1.1,  -1.1 },
-		{ -1.05, -1.05,  -1.1, -1.25, -1.25,  -1.1, -1.05, -1.05 },
-		{  -1.0,  -1.0,  -1.0,  -1.2,  -1.2,  -1.0,  -1.0,  -1.0 },
-		{ -1.05, -0.95,  -0.9,  -1.0,  -1.0,  -0.9, -0.95, -1.05 },
-		{ -1.05,  -1.1,  -1.1,  -0.8,  -0.8,  -1.1,  -1.1, -1.05 },
-		{   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0 }
-	},
-	{ // Black knight
-		{  -2.7,  -2.8,  -2.9,  -2.9,  -2.9,  -2.9,  -2.8,  -2.7 },
-		{  -2.8,  -3.0,  -3.2,  -3.2,  -3.2,  -3.2,  -3.0,  -2.8 },
-		{  -2.9,  -3.2,  -3.3, -3.35, -3.35,  -3.3,  -3.2,  -2.9 },
-		{  -2.9, -3.25, -3.35,  -3.4,  -3.4, -3.35, -3.25,  -2.9 },
-		{  -2.9,  -3.2, -3.35,  -3.4,  -3.4, -3.35,  -3.2,  -2.9 },
-		{  -2.9, -3.25,  -3.3, -3.35, -3.35,  -3.3, -3.25,  -2.9 },
-		{  -2.8,  -3.0,  -3.2, -3.25, -3.25,  -3.2,  -3.0,  -2.8 },
-		{  -2.7,  -2.8,  -2.9,  -2.9,  -2.9,  -2.9,  -2.8,  -2.7 }
-	},
-	{ // Black bishop
-		{  -3.1,  -3.2,  -3.2,  -3.2,  -3.2,  -3.2,  -3.2,  -3.1 },
-		{  -3.2,  -3.3,  -3.3,  -3.3,  -3.3,  -3.3,  -3.3,  -3.2 },
-		{  -3.2,  -3.3, -3.35,  -3.4,  -3.4, -3.35,  -3.3,  -3.2 },
-		{  -3.2, -3.35, -3.35,  -3.4,  -3.4, -3.35, -3.35,  -3.2 },
-		{  -3.2,  -3.3,  -3.4,  -3.4,  -3.4,  -3.4,  -3.3,  -3.2 },
-		{  -3.2,  -3.4,  -3.4,  -3.4,  -3.4,  -3.4,  -3.4,  -3.2 },
-		{  -3.2, -3.35,  -3.3,  -3.3,  -3.3,  -3.3, -3.35,  -3.2 },
-		{  -3.1,  -3.2,  -3.2,  -3.2,  -3.2,  -3.2,  -3.2,  -3.1 }
-	},
-	{ // Black rook
-		{  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0 },
-		{ -5.05,  -5.1,  -5.1,  -5.1,  -5.1,  -5.1,  -5.1, -5.05 },
-		{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
-		{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
-		{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
-		{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
-		{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
-		{  -5.0,  -5.0,  -5.0, -5.05, -5.05,  -5.0,  -5.0,  -5.0 }
-	},
-	{ // Black queen
-		{  -8.8,  -8.9,  -8.9, -8.95, -8.95,  -8.9,  -8.9,  -8.8 },
-		{  -8.9,  -9.0,  -9.0,  -9.0,  -9.0,  -9.0,  -9.0,  -8.9 },
-		{  -8.9,  -9.0, -9.05, -9.05, -9.05, -9.05,  -9.0,  -8.9 },
-		{ -8.95,  -9.0, -9.05, -9.05, -9.05, -9.05,  -9.0, -8.95 },
-		{  -9.0,  -9.0, -9.05, -9.05, -9.05, -9.05,  -9.0, -8.95 },
-		{  -8.9, -9.05, -9.05, -9.05, -9.05, -9.05,  -9.0,  -8.9 },
-		{  -8.9,  -9.0, -9.05,  -9.0,  -9.0,  -9.0,  -9.0,  -8.9 },
-		{  -8.8,  -8.9,  -8.9, -8.95, -8.95,  -8.9,  -8.9,  -8.8 }
-	},
-	{ // Black king midgame
-		{   0.3,   0.4,   0.4,   0.5,   0.5,   0.4,   0.4,   0.3 },
-		{   0.3,   0.4,   0.4,   0.5,   0.5,   0.4,   0.4,   0.3 },
-		{   0.3,   0.4,   0.4,   0.5,   0.5,   0.4,   0.4,   0.3 },
-		{   0.3,   0.4,   0.4,   0.5,   0.5,   0.4,   0.4,   0.3 },
-		{   0.2,   0.3,   0.3,   0.4,   0.4,   0.3,   0.3,   0.2 },
-		{   0.1,   0.2,   0.2,   0.2,   0.2,   0.2,   0.2,   0.1 },
-		{  -0.2,  -0.2,   0.0,   0.0,   0.0,   0.0,  -0.2,  -0.2 },
-		{  -0.2,  -0.3,  -0.1,   0.0,   0.0,  -0.1,  -0.3,  -0.2 }
-	},
-	{ // Black king endgame
-		{   0.5,   0.4,   0.3,   0.2,   0.2,   0.3,   0.4,   0.5 },
-		{   0.3,   0.2,   0.1,   0.0,   0.0,   0.1,   0.2,   0.3 },
-		{   0.3,   0.1,  -0.2,  -0.3,  -0.3,  -0.2,   0.1,   0.3 },
-		{   0.3,   0.1,  -0.3,  -0.4,  -0.4,  -0.3,   0.1,   0.3 },
-		{   0.3,   0.1,  -0.3,  -0.4,  -0.4,  -0.3,   0.1,   0.3 },
-		{   0.3,   0.1,  -0.2,  -0.3,  -0.3,  -0.2,   0.1,   0.3 },
-		{   0.3,   0.3,   0.0,   0.0,   0.0,   0.0,   0.3,   0.3 },
-		{   0.5,   0.3,   0.3,   0.3,   0.3,   0.3,   0.3,   0.5 }
-	},
-	{ },
-	{ // White pawn
-		{   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0 },
-		{  1.05,   1.1,   1.1,   0.8,   0.8,   1.1,   1.1,  1.05 },
-		{  1.05,  0.95,   0.9,   1.0,   1.0,   0.9,  0.95,  1.05 },
-		{   1.0,   1.0,   1.0,   1.2,   1.2,   1.0,   1.0,   1.0 },
-		{  1.05,  1.05,   1.1,  1.25,  1.25,   1.1,  1.05,  1.05 },
-		{   1.1,   1.1,   1.2,   1.3,   1.3,   1.2,   1.1,   1.1 },
-		{   1.5,   1.5,   1.5,   1.5,   1.5,   1.5,   1.5,   1.5 },
-		{   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0 }
-	},
-	{ // White knight
-		{   2.7,   2.8,   2.9,   2.9,   2.9,   2.9,   2.8,   2.7 },
-		{   2.8,   3.0,   3.2,  3.25,  3.25,   3.2,   3.0,   2.8 },
-		{   2.9,  3.25,   3.3,  3.35,  3.35,   3.3,  3.25,   2.9 },
-		{   2.9,   3.2,  3.35,   3.4,   3.4,  3.35,   3.2,   2.9 },
-		{   2.9,  3.25,  3.35,   3.4,   3.4,  3.35,  3.25,   2.9 },
-		{   2.9,   3.2,   3.3,  3.35,  3.35,   3.3,   3.2,   2.9 },
-		{   2.8,   3.0,   3.2,   3.2,   3.2,   3.2,   3.0,   2.8 },
-		{   2.7,   2.8,   2.9,   2.9,   2.9,   2.9,   2.8,   2.7 }
-	},
-	{ // White bishop
-		{   3.1,   3.2,   3.2,   3.2,   3.2,   3.2,   3.2,   3.1 },
-		{   3.2,  3.35,   3.3,   3.3,   3.3,   3.3,  3.35,   3.2 },
-		{   3.2,   3.4,   3.4,   3.4,   3.4,   3.4,   3.4,   3.2 },
-		{   3.2,   3.3,   3.4,   3.4,   3.4,   3.4,   3.3,   3.2 },
-		{   3.2,  3.35,  3.35,   3.4,   3.4,  3.35,  3.35,   3.2 },
-		{   3.2,   3.3,  3.35,   3.4,   3.4,  3.35,   3.3,   3.2 },
-		{   3.2,   3.3,   3.3,   3.3,   3.3,   3.3,   3.3,   3.2 },
-		{   3.1,   3.2,   3.2,   3.2,   3.2,   3.2,   3.2,   3.1 }
-	},
-	{ // White rook
-		{   5.0,   5.0,   5.0,  5.05,  5.05,   5.0,   5.0,   5.0 },
-		{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
-		{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
-		{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
-		{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
-		{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
-		{  5.05,   5.1,   5.1,   5.1,   5.1,   5.1,   5.1,  5.05 },
-		{   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0 }
-	},
-	{ // White queen
-		{   8.8,   8.9,   8.9,  8.95,  8.95,   8.9,   8.9,   8.8 },
-		{   8.9,   9.0,  9.05,   9.0,   9.0,   9.0,   9.0,   8.9 },
-		{   8.9,  9.05,  9.05,  9.05,  9.05,  9.05,   9.0,   8.9 },
-		{   9.0,   9.0,  9.05,  9.05,  9.05,  9.05,   9.0,  8.95 },
-		{  8.95,   9.0,  9.05,  9.05,  9.05,  9.05,   9.0,  8.95 },
-		{   8.9,   9.0,  9.05,  9.05,  9.05,  9.05,   9.0,   8.9 },
-		{   8.9,   9.0,   9.0,   9.0,   9.0,   9.0,   9.0,   8.9 },
-		{   8.8,   8.9,   8.9,  8.95,  8.95,   8.9,   8.9,   8.8 }
-	},
-	{ // White king midgame
-		{   0.2,   0.3,   0.1,   0.0,   0.0,   0.1,   0.3,   0.2 },
-		{   0.2,   0.2,   0.0,   0.0,   0.0,   0.0,   0.2,   0.2 },
-		{  -0.1,  -0.2,  -0.2,  -0.2,  -0.2,  -0.2,  -0.2,  -0.1 },
-		{  -0.2,  -0.3,  -0.3,  -0.4,  -0.4,  -0.3,  -0.3,  -0.2 },
-		{  -0.3,  -0.4,  -0.4,  -0.5,  -0.5,  -0.4,  -0.4,  -0.3 },
-		{  -0.3,  -0.4,  -0.4,  -0.5,  -0.5,  -0.4,  -0.4,  -0.3 },
-		{  -0.3,  -0.4,  -0.4,  -0.5,  -0.5,  -0.4,  -0.4,  -0.3 },
-		{  -0.3,  -0.4,  -0.4,  -0.5,  -0.5,  -0.4,  -0.4,  -0.3 }
-	},
-	{ // White king endgame
-		{  -0.5,  -0.3,  -0.3,  -0.3,  -0.3,  -0.3,  -0.3,  -0.5 },
-		{  -0.3,  -0.3,   0.0,   0.0,   0.0,   0.0,  -0.3,  -0.3 },
-		{  -0.3,  -0.1,   0.2,   0.3,   0.3,   0.2,  -0.1,  -0.3 },
-		{  -0.3,  -0.1,   0.3,   0.4,   0.4,   0.3,  -0.1,  -0.3 },
-		{  -0.3,  -0.1,   0.3,   0.4,   0.4,   0.3,  -0.1,  -0.3 },
-		{  -0.3,  -0.1,   0.2,   0.3,   0.3,   0.2,  -0.1,  -0.3 },
-		{  -0.3,  -0.2,  -0.1,   0.0,   0.0,  -0.1,  -0.2,  -0.3 },
-		{  -0.5,  -0.4,  -0.3,  -0.2,  -0.2,  -0.3,  -0.4,  -0.5 }
-	}
-};
+#include <array>
+#include <cstdint>
+
+namespace chess
+{
+	inline constexpr float PSQT[16][8][8] = {
+		{ },
+		{ // Black pawn
+			{   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0 },
+			{  -1.5,  -1.5,  -1.5,  -1.5,  -1.5,  -1.5,  -1.5,  -1.5 },
+			{  -1.1,  -1.1,  -1.2,  -1.3,  -1.3,  -1.2,  -1.1,  -1.1 },
+			{ -1.05, -1.05,  -1.1, -1.25, -1.25,  -1.1, -1.05, -1.05 },
+			{  -1.0,  -1.0,  -1.0,  -1.2,  -1.2,  -1.0,  -1.0,  -1.0 },
+			{ -1.05, -0.95,  -0.9,  -1.0,  -1.0,  -0.9, -0.95, -1.05 },
+			{ -1.05,  -1.1,  -1.1,  -0.8,  -0.8,  -1.1,  -1.1, -1.05 },
+			{   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0 }
+		},
+		{ // Black knight
+			{  -2.7,  -2.8,  -2.9,  -2.9,  -2.9,  -2.9,  -2.8,  -2.7 },
+			{  -2.8,  -3.0,  -3.2,  -3.2,  -3.2,  -3.2,  -3.0,  -2.8 },
+			{  -2.9,  -3.2,  -3.3, -3.35, -3.35,  -3.3,  -3.2,  -2.9 },
+			{  -2.9, -3.25, -3.35,  -3.4,  -3.4, -3.35, -3.25,  -2.9 },
+			{  -2.9,  -3.2, -3.35,  -3.4,  -3.4, -3.35,  -3.2,  -2.9 },
+			{  -2.9, -3.25,  -3.3, -3.35, -3.35,  -3.3, -3.25,  -2.9 },
+			{  -2.8,  -3.0,  -3.2, -3.25, -3.25,  -3.2,  -3.0,  -2.8 },
+			{  -2.7,  -2.8,  -2.9,  -2.9,  -2.9,  -2.9,  -2.8,  -2.7 }
+		},
+		{ // Black bishop
+			{  -3.1,  -3.2,  -3.2,  -3.2,  -3.2,  -3.2,  -3.2,  -3.1 },
+			{  -3.2,  -3.3,  -3.3,  -3.3,  -3.3,  -3.3,  -3.3,  -3.2 },
+			{  -3.2,  -3.3, -3.35,  -3.4,  -3.4, -3.35,  -3.3,  -3.2 },
+			{  -3.2, -3.35, -3.35,  -3.4,  -3.4, -3.35, -3.35,  -3.2 },
+			{  -3.2,  -3.3,  -3.4,  -3.4,  -3.4,  -3.4,  -3.3,  -3.2 },
+			{  -3.2,  -3.4,  -3.4,  -3.4,  -3.4,  -3.4,  -3.4,  -3.2 },
+			{  -3.2, -3.35,  -3.3,  -3.3,  -3.3,  -3.3, -3.35,  -3.2 },
+			{  -3.1,  -3.2,  -3.2,  -3.2,  -3.2,  -3.2,  -3.2,  -3.1 }
+		},
+		{ // Black rook
+			{  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0 },
+			{ -5.05,  -5.1,  -5.1,  -5.1,  -5.1,  -5.1,  -5.1, -5.05 },
+			{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
+			{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
+			{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
+			{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
+			{ -4.95,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0,  -5.0, -4.95 },
+			{  -5.0,  -5.0,  -5.0, -5.05, -5.05,  -5.0,  -5.0,  -5.0 }
+		},
+		{ // Black queen
+			{  -8.8,  -8.9,  -8.9, -8.95, -8.95,  -8.9,  -8.9,  -8.8 },
+			{  -8.9,  -9.0,  -9.0,  -9.0,  -9.0,  -9.0,  -9.0,  -8.9 },
+			{  -8.9,  -9.0, -9.05, -9.05, -9.05, -9.05,  -9.0,  -8.9 },
+			{ -8.95,  -9.0, -9.05, -9.05, -9.05, -9.05,  -9.0, -8.95 },
+			{  -9.0,  -9.0, -9.05, -9.05, -9.05, -9.05,  -9.0, -8.95 },
+			{  -8.9, -9.05, -9.05, -9.05, -9.05, -9.05,  -9.0,  -8.9 },
+			{  -8.9,  -9.0, -9.05,  -9.0,  -9.0,  -9.0,  -9.0,  -8.9 },
+			{  -8.8,  -8.9,  -8.9, -8.95, -8.95,  -8.9,  -8.9,  -8.8 }
+		},
+		{ // Black king midgame
+			{   0.3,   0.4,   0.4,   0.5,   0.5,   0.4,   0.4,   0.3 },
+			{   0.3,   0.4,   0.4,   0.5,   0.5,   0.4,   0.4,   0.3 },
+			{   0.3,   0.4,   0.4,   0.5,   0.5,   0.4,   0.4,   0.3 },
+			{   0.3,   0.4,   0.4,   0.5,   0.5,   0.4,   0.4,   0.3 },
+			{   0.2,   0.3,   0.3,   0.4,   0.4,   0.3,   0.3,   0.2 },
+			{   0.1,   0.2,   0.2,   0.2,   0.2,   0.2,   0.2,   0.1 },
+			{  -0.2,  -0.2,   0.0,   0.0,   0.0,   0.0,  -0.2,  -0.2 },
+			{  -0.2,  -0.3,  -0.1,   0.0,   0.0,  -0.1,  -0.3,  -0.2 }
+		},
+		{ // Black king endgame
+			{   0.5,   0.4,   0.3,   0.2,   0.2,   0.3,   0.4,   0.5 },
+			{   0.3,   0.2,   0.1,   0.0,   0.0,   0.1,   0.2,   0.3 },
+			{   0.3,   0.1,  -0.2,  -0.3,  -0.3,  -0.2,   0.1,   0.3 },
+			{   0.3,   0.1,  -0.3,  -0.4,  -0.4,  -0.3,   0.1,   0.3 },
+			{   0.3,   0.1,  -0.3,  -0.4,  -0.4,  -0.3,   0.1,   0.3 },
+			{   0.3,   0.1,  -0.2,  -0.3,  -0.3,  -0.2,   0.1,   0.3 },
+			{   0.3,   0.3,   0.0,   0.0,   0.0,   0.0,   0.3,   0.3 },
+			{   0.5,   0.3,   0.3,   0.3,   0.3,   0.3,   0.3,   0.5 }
+		},
+		{ },
+		{ // White pawn
+			{   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0 },
+			{  1.05,   1.1,   1.1,   0.8,   0.8,   1.1,   1.1,  1.05 },
+			{  1.05,  0.95,   0.9,   1.0,   1.0,   0.9,  0.95,  1.05 },
+			{   1.0,   1.0,   1.0,   1.2,   1.2,   1.0,   1.0,   1.0 },
+			{  1.05,  1.05,   1.1,  1.25,  1.25,   1.1,  1.05,  1.05 },
+			{   1.1,   1.1,   1.2,   1.3,   1.3,   1.2,   1.1,   1.1 },
+			{   1.5,   1.5,   1.5,   1.5,   1.5,   1.5,   1.5,   1.5 },
+			{   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0,   0.0 }
+		},
+		{ // White knight
+			{   2.7,   2.8,   2.9,   2.9,   2.9,   2.9,   2.8,   2.7 },
+			{   2.8,   3.0,   3.2,  3.25,  3.25,   3.2,   3.0,   2.8 },
+			{   2.9,  3.25,   3.3,  3.35,  3.35,   3.3,  3.25,   2.9 },
+			{   2.9,   3.2,  3.35,   3.4,   3.4,  3.35,   3.2,   2.9 },
+			{   2.9,  3.25,  3.35,   3.4,   3.4,  3.35,  3.25,   2.9 },
+			{   2.9,   3.2,   3.3,  3.35,  3.35,   3.3,   3.2,   2.9 },
+			{   2.8,   3.0,   3.2,   3.2,   3.2,   3.2,   3.0,   2.8 },
+			{   2.7,   2.8,   2.9,   2.9,   2.9,   2.9,   2.8,   2.7 }
+		},
+		{ // White bishop
+			{   3.1,   3.2,   3.2,   3.2,   3.2,   3.2,   3.2,   3.1 },
+			{   3.2,  3.35,   3.3,   3.3,   3.3,   3.3,  3.35,   3.2 },
+			{   3.2,   3.4,   3.4,   3.4,   3.4,   3.4,   3.4,   3.2 },
+			{   3.2,   3.3,   3.4,   3.4,   3.4,   3.4,   3.3,   3.2 },
+			{   3.2,  3.35,  3.35,   3.4,   3.4,  3.35,  3.35,   3.2 },
+			{   3.2,   3.3,  3.35,   3.4,   3.4,  3.35,   3.3,   3.2 },
+			{   3.2,   3.3,   3.3,   3.3,   3.3,   3.3,   3.3,   3.2 },
+			{   3.1,   3.2,   3.2,   3.2,   3.2,   3.2,   3.2,   3.1 }
+		},
+		{ // White rook
+			{   5.0,   5.0,   5.0,  5.05,  5.05,   5.0,   5.0,   5.0 },
+			{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
+			{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
+			{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
+			{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
+			{  4.95,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,  4.95 },
+			{  5.05,   5.1,   5.1,   5.1,   5.1,   5.1,   5.1,  5.05 },
+			{   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0,   5.0 }
+		},
+		{ // White queen
+			{   8.8,   8.9,   8.9,  8.95,  8.95,   8.9,   8.9,   8.8 },
+			{   8.9,   9.0,  9.05,   9.0,   9.0,   9.0,   9.0,   8.9 },
+			{   8.9,  9.05,  9.05,  9.05,  9.05,  9.05,   9.0,   8.9 },
+			{   9.0,   9.0,  9.05,  9.05,  9.05,  9.05,   9.0,  8.95 },
+			{  8.95,   9.0,  9.05,  9.05,  9.05,  9.05,   9.0,  8.95 },
+			{   8.9,   9.0,  9.05,  9.05,  9.05,  9.05,   9.0,   8.9 },
+			{   8.9,   9.0,   9.0,   9.0,   9.0,   9.0,   9.0,   8.9 },
+			{   8.8,   8.9,   8.9,  8.95,  8.95,   8.9,   8.9,   8.8 }
+		},
+		{ // White king midgame
+			{   0.2,   0.3,   0.1,   0.0,   0.0,   0.1,   0.3,   0.2 },
+			{   0.2,   0.2,   0.0,   0.0,   0.0,   0.0,   0.2,   0.2 },
+			{  -0.1,  -0.2,  -0.2,  -0.2,  -0.2,  -0.2,  -0.2,  -0.1 },
+			{  -0.2,  -0.3,  -0.3,  -0.4,  -0.4,  -0.3,  -0.3,  -0.2 },
+			{  -0.3,  -0.4,  -0.4,  -0.5,  -0.5,  -0.4,  -0.4,  -0.3 },
+			{  -0.3,  -0.4,  -0.4,  -0.5,  -0.5,  -0.4,  -0.4,  -0.3 },
+			{  -0.3,  -0.4,  -0.4,  -0.5,  -0.5,  -0.4,  -0.4,  -0.3 },
+			{  -0.3,  -0.4,  -0.4,  -0.5,  -0.5,  -0.4,  -0.4,  -0.3 }
+		},
+		{ // White king endgame
+			{  -0.5,  -0.3,  -0.3,  -0.3,  -0.3,  -0.3,  -0.3,  -0.5 },
+			{  -0.3,  -0.3,   0.0,   0.0,   0.0,   0.0,  -0.3,  -0.3 },
+			{  -0.3,  -0.1,   0.2,   0.3,   0.3,   0.2,  -0.1,  -0.3 },
+			{  -0.3,  -0.1,   0.3,   0.4,   0.4,   0.3,  -0.1,  -0.3 },
+			{  -0.3,  -0.1,   0.3,   0.4,   0.4,   0.3,  -0.1,  -0.3 },
+			{  -0.3,  -0.1,   0.2,   0.3,   0.3,   0.2,  -0.1,  -0.3 },
+			{  -0.3,  -0.2,  -0.1,   0.0,   0.0,  -0.1,  -0.2,  -0.3 },
+			{  -0.5,  -0.4,  -0.3,  -0.2,  -0.2,  -0.3,  -0.4,  -0.5 }
+		}
+	};
+
+	// PSQT in whole centipawns, indexed by piece and square (rank*8 + file)
+	// Sums of integers can be kept up to date as pieces move without rounding drift
+	inline constexpr std::array<std::array<int16_t, 64>, 16> PSQT_CENTIPAWNS = [] {
+		std::array<std::array<int16_t, 64>, 16> table {};
+		for (unsigned int piece=0; piece<16; piece++)
+			for (unsigned int square=0; square<64; square++) {
+				float value = PSQT[piece][square / 8][square % 8] * 100;
+				table[piece][square] = static_cast<int16_t>(value + (value < 0 ? -0.5f : 0.5f));
+			}
+		return table;
+	}();
+}
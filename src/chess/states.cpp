@@ -1,212 +1,277 @@
-#include <regex>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <algorithm>
 #include <stdexcept>
-
-#include "../game.h"
+#include <cstdlib>
 
 #include "states.h"
 #include "pieces.h"
+#include "zobrist.h"
 
-extern const std::string STARTING_FEN {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"};
-
-const std::regex FEN_regex(
-	// Ranks index 1-8
-	"([1-8kqrbnpKQRBNP]{1,8})\\/"
-	"([1-8kqrbnpKQRBNP]{1,8})\\/"
-	"([1-8kqrbnpKQRBNP]{1,8})\\/"
-	"([1-8kqrbnpKQRBNP]{1,8})\\/"
-	"([1-8kqrbnpKQRBNP]{1,8})\\/"
-	"([1-8kqrbnpKQRBNP]{1,8})\\/"
-	"([1-8kqrbnpKQRBNP]{1,8})\\/"
-	"([1-8kqrbnpKQRBNP]{1,8}) "
-	// To move index 9
-	"([wb]) "
-	// Castling avaliability index 10
-	"(-|(?:K?Q?k?q?)) "
-	// En passant target square index 11
-	"(-|[a-h][36]) "
-	// Halfmove clock index 12
-	"(\\d+) "
-	// Fullmove clock, not needed
-	"(?:\\d+)"
-);
-
-void deleteState(Gamestate* state) {
-	delete state;
-}
-
-void deleteAction(Action* action) {
-	delete action;
-}
+namespace chess
+{
+	extern const std::string STARTING_FEN {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"};
+
+	namespace
+	{
+		// Reads a FEN one character at a time, in a single pass without allocating
+		// Anything not in the format `FEN ::= ranks side castling passant halfmove fullmove`
+		// with the fields separated by single spaces is an improper FEN
+		struct FENReader
+		{
+			std::string_view FEN;
+			size_t pos = 0;
+
+			[[noreturn]] static void improper() { throw std::invalid_argument("Improper FEN"); }
+
+			inline char peek() const { return pos < FEN.size() ? FEN[pos] : '\0'; }
+			inline char next() { return pos < FEN.size() ? FEN[pos++] : '\0'; }
+
+			// Skip `c` if it is the next character
+			inline bool accept(char c)
+			{
+				if (peek() != c)
+					return false;
+				pos++;
+				return true;
+			}
 
-Action::Action(Coordinate from, Coordinate to, Piece promotionPiece)
-	: from{from}, to{to}, promotionPiece{promotionPiece} {}
+			inline void expect(char c)
+			{
+				if (!accept(c))
+					improper();
+			}
 
-std::string Action::toAN() const {
-	std::string s {from.toString()};
-	s += to.toString();
-	if (pieceType(promotionPiece) != NONE) {
-		s += pieceToSymbol[promotionPiece];
+			unsigned int number()
+			{
+				// One or more decimal digits, large values are clamped
+				if (peek() < '0' || peek() > '9')
+					improper();
+				unsigned int n = 0;
+				while (peek() >= '0' && peek() <= '9')
+					n = std::min(n * 10 + (next() - '0'), 1000000u);
+				return n;
+			}
+		};
 	}
-	return s;
-}
 
-std::string Action::toString() const {
-	std::string s {from.toString()};
-	s += " ";
-	s += to.toString();
-	if (pieceType(promotionPiece) != NONE) {
-		s += "=";
-		s += pieceToSymbol[promotionPiece];
-	}
-	return s;
-}
+	uint64_t Chess::hashState(Gamestate const* statep) {
+		// The board keeps the Zobrist key of the pieces up to date as moves are
+		// made, the remaining features are added here
+		uint64_t key = statep->board.key;
 
-bool Action::operator ==(const Action& b) const
-{
-	return from == b.from &&
-		to == b.to &&
-		promotionPiece == b.promotionPiece;
-}
-
-Gamestate::Gamestate(std::string FEN)
-	: whiteCastle{false, false}, blackCastle{false, false}
-{
-	// Set state according to provided FEN
-	// The input is trusted; only basic validation is done
-
-	std::string target;
-	std::smatch FEN_match;
-	char c;
-	Piece tmpPiece;
-	Castle *castleTarget;
-
-	std::regex_match(FEN, FEN_match, FEN_regex);
-
-	if (FEN_match.empty())
-		throw std::invalid_argument("Improper FEN");
-
-	// Read board
-	for (int rank=7; rank>=0; rank--) {
-		int file = 0;
-		target = FEN_match[8 - rank];
-		for (unsigned int i=0; i<target.size(); i++) {
-			if (file >= 8)
-				throw std::invalid_argument("Too many pieces on a single rank");
-
-			c = target[i];
-			if (isdigit(c)) {
-				// Add empty squares
-				for (int j = 0; j<c-'0'; j++) {
-					board.set({rank, file}, NONE);
-					file++;
-				}
-			} else {
-				// Add piece
-				board.set({rank, file}, symbolToPiece(c));
-				file++;
-			}
-		}
-	}
+		if (statep->whiteToMove)
+			key ^= ZOBRIST.whiteToMove;
 
-	// Active color
-	whiteToMove = FEN_match[9] == 'w';
+		key ^= ZOBRIST.castle[statep->castling];
 
-	// Castling avaliability one or more of 'K', 'Q', 'k', 'q'
-	target = FEN_match[10];
+		if (statep->passantSquare != NO_SQUARE)
+			key ^= ZOBRIST.passantFile[statep->passantSquare % 8];
 
-	if (target[0] != '-') {
-		for (unsigned int i=0; i<target.size(); i++) {
-			c = target[i];
-			tmpPiece = symbolToPiece(c);
+		return key;
+	}
 
-			// Obtain reference to whites/blacks castle struct
-			if (pieceColor(tmpPiece) == WHITE)
-				castleTarget = &whiteCastle;
-			else
-				castleTarget = &blackCastle;
+	Action Action::fromAN(const std::string& AN, const Gamestate& state)
+	{
+		if (AN.size() < 4 || AN.size() > 5)
+			throw std::invalid_argument("Invalid move: " + AN);
+
+		Coordinate from {AN.substr(0, 2)};
+		Coordinate to {AN.substr(2, 2)};
+		if (!from.isValid() || !to.isValid())
+			throw std::invalid_argument("Invalid move: " + AN);
+
+		// The flags follow from the moved piece
+		Piece movedPiece = state.board.get(from);
+		if (AN.size() == 5) {
+			Piece promotion = pieceType(symbolToPiece(AN[4]));
+			if (promotion < KNIGHT || promotion > QUEEN)
+				throw std::invalid_argument("Invalid promotion: " + AN);
+			return {from, to, promotionFlag(promotion)};
+		}
+		if (pieceType(movedPiece) == KING && std::abs(to.file - from.file) == 2)
+			return {from, to, CASTLE};
+		if (pieceType(movedPiece) == PAWN && to.square() == state.passantSquare)
+			return {from, to, PASSANT};
+		return {from, to};
+	}
 
-			// Set the relevant field
-			if (pieceType(tmpPiece) == KING)
-				castleTarget->kingside = true;
-			else
-				castleTarget->queenside = true;
+	std::string Action::toAN() const {
+		std::string s {from().toString()};
+		s += to().toString();
+		if (isPromotion()) {
+			s += pieceToSymbol[promotionPiece()];
 		}
+		return s;
 	}
 
-	// En passant target square
-	if (FEN_match[11] == '-') {
-		// No passant pawn
-		passantSquare = {-1, -1};
-	} else {
-		// Construct the coordinate from the SAN-representation
-		passantSquare = {FEN_match[11]};
+	std::string Action::toString() const {
+		std::string s {from().toString()};
+		s += " ";
+		s += to().toString();
+		if (isPromotion()) {
+			s += "=";
+			s += pieceToSymbol[promotionPiece()];
+		}
+		return s;
 	}
 
+	Gamestate::Gamestate(std::string_view FEN)
+		: castling{0}
+	{
+		// Set state according to provided FEN
+		// The input is trusted; only basic validation is done
+		FENReader reader {FEN};
+		// Reported once the whole FEN is known to be proper
+		bool overfullRank = false;
+
+		// Board, ranks 8 to 1 separated by '/', each of 1-8 pieces or amounts of empty squares
+		for (int rank=7; rank>=0; rank--) {
+			int file = 0;
+			unsigned int length = 0;
+			for (char c; (c = reader.peek()) != '/' && c != ' '; length++) {
+				reader.next();
+				if (c >= '1' && c <= '8') {
+					// Skip empty squares
+					file += c - '0';
+					continue;
+				}
 
-	// Halfmove clock (since pawn move or capture)
-	rule50Ply = std::stoi(FEN_match[12]);
+				Piece piece = symbolToPiece(c);
+				if (pieceType(piece) == NONE || pieceType(piece) == UNKNOWN)
+					reader.improper();
+				if (file >= 8)
+					overfullRank = true;
+				else
+					board.set({rank, file}, piece);
+				file++;
+			}
+			if (length == 0 || length > 8)
+				reader.improper();
+			if (file > 8)
+				overfullRank = true;
+			reader.expect(rank ? '/' : ' ');
+		}
 
-	// Fullmove number is not relevant to the evaluation of the position, and is skipped
-}
+		// Active color
+		char side = reader.next();
+		if (side != 'w' && side != 'b')
+			reader.improper();
+		whiteToMove = side == 'w';
+		reader.expect(' ');
+
+		// Castling avaliability '-', or one or more of 'K', 'Q', 'k', 'q' in that order
+		if (!reader.accept('-')) {
+			if (reader.accept('K'))
+				castling |= WHITE_KINGSIDE;
+			if (reader.accept('Q'))
+				castling |= WHITE_QUEENSIDE;
+			if (reader.accept('k'))
+				castling |= BLACK_KINGSIDE;
+			if (reader.accept('q'))
+				castling |= BLACK_QUEENSIDE;
+		}
+		reader.expect(' ');
+
+		// En passant target square
+		if (reader.accept('-')) {
+			// No passant pawn
+			passantSquare = NO_SQUARE;
+		} else {
+			// Only squares a pawn can pass are proper
+			char file = reader.next();
+			char rank = reader.next();
+			if (file < 'a' || file > 'h' || (rank != '3' && rank != '6'))
+				reader.improper();
+			passantSquare = Coordinate{rank - '1', file - 'a'}.square();
+		}
+		reader.expect(' ');
 
-Gamestate::Gamestate() : Gamestate(STARTING_FEN) {}
+		// Halfmove clock (since pawn move or capture)
+		rule50Ply = std::min(reader.number(), 255u);
+		reader.expect(' ');
 
-std::string Gamestate::toFEN() const
-{
-	std::ostringstream oss;
-
-	// Board
-	unsigned int amtEmpty=0;
-	for (int rank=7; rank>=0; rank--) {
-		for (int file=0; file<=7; file++) {
-			Piece p = board.get({rank, file});
-			if (pieceType(p) == NONE) {
-				amtEmpty++;
-			} else {
-				if (amtEmpty) {
-					oss << amtEmpty;
-					amtEmpty = 0;
+		// Fullmove number is not relevant to the evaluation of the position, and is skipped
+		reader.number();
+		if (reader.pos != FEN.size())
+			reader.improper();
+
+		if (overfullRank)
+			throw std::invalid_argument("Too many pieces on a single rank");
+
+		if (!board.pieces(WHITE, KING) || !board.pieces(BLACK, KING))
+			throw std::invalid_argument("Board does not have a king of each color");
+	}
+
+	Gamestate::Gamestate() : Gamestate(STARTING_FEN) {}
+
+	std::string Gamestate::toFEN() const
+	{
+		// Written to a buffer, so the string is allocated once
+		// The longest board has 64 pieces and 7 '/', the other fields take at most 16
+		char FEN[96];
+		char* out = FEN;
+
+		// Board
+		for (int rank=7; rank>=0; rank--) {
+			char amtEmpty = 0;
+			for (int file=0; file<=7; file++) {
+				Piece p = board.get({rank, file});
+				if (pieceType(p) == NONE) {
+					amtEmpty++;
+				} else {
+					if (amtEmpty) {
+						*out++ = '0' + amtEmpty;
+						amtEmpty = 0;
+					}
+					*out++ = pieceToSymbol[p];
 				}
-				oss << pieceToSymbol[p];
 			}
+			if (amtEmpty)
+				*out++ = '0' + amtEmpty;
+			if (rank != 0)
+				*out++ = '/';
 		}
-		if (amtEmpty) {
-			oss << amtEmpty;
-			amtEmpty = 0;
-		}
-		if (rank != 0)
-			oss << "/";
-	}
 
-	// To move
-	oss << (whiteToMove ? " w " : " b ");
-
-	if (whiteCastle.canCastle() || blackCastle.canCastle()) {
-		if (whiteCastle.kingside)
-			oss << "K";
-		if (whiteCastle.queenside)
-			oss << "Q";
-		if (blackCastle.kingside)
-			oss << "k";
-		if (blackCastle.queenside)
-			oss << "q";
-	} else {
-		oss << "-";
-	}
+		// To move
+		*out++ = ' ';
+		*out++ = whiteToMove ? 'w' : 'b';
+		*out++ = ' ';
+
+		if (castling) {
+			if (castling & WHITE_KINGSIDE)
+				*out++ = 'K';
+			if (castling & WHITE_QUEENSIDE)
+				*out++ = 'Q';
+			if (castling & BLACK_KINGSIDE)
+				*out++ = 'k';
+			if (castling & BLACK_QUEENSIDE)
+				*out++ = 'q';
+		} else {
+			*out++ = '-';
+		}
 
-	// En passant target square
-	if (!passantSquare.isValid())
-		oss << " - ";
-	else
-		oss << " " << passantSquare.toString() << " ";
+		// En passant target square
+		*out++ = ' ';
+		if (passantSquare == NO_SQUARE) {
+			*out++ = '-';
+		} else {
+			*out++ = 'a' + passantSquare % 8;
+			*out++ = '1' + passantSquare / 8;
+		}
+		*out++ = ' ';
 
-	// Halfmove clock since last capture/pawn move
-	oss << static_cast<unsigned int>(rule50Ply) << " ";
+		// Halfmove clock since last capture/pawn move
+		if (rule50Ply >= 100)
+			*out++ = '0' + rule50Ply / 100;
+		if (rule50Ply >= 10)
+			*out++ = '0' + rule50Ply / 10 % 10;
+		*out++ = '0' + rule50Ply % 10;
 
-	// Fullmove clock, not stored in this state
-	oss << 1;
+		// Fullmove clock, not stored in this state
+		*out++ = ' ';
+		*out++ = '1';
 
-	return oss.str();
+		return std::string(FEN, out);
+	}
 }
@@ -1,65 +1,187 @@
-#ifndef STATES_H_INCLUDED
-#define STATES_H_INCLUDED
+#ifndef CHESS_STATES_H_INCLUDED
+#define CHESS_STATES_H_INCLUDED
 
 #include "board.h"
 #include "pieces.h"
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <cstdint>
 #include <cmath>
 
 #include <iostream>
 
-extern const std::string STARTING_FEN;
-
-struct Action
+namespace chess
 {
-	Coordinate from;
-	Coordinate to;
-	Piece promotionPiece;
+	extern const std::string STARTING_FEN;
 
-	Action(Coordinate from, Coordinate to, Piece promotionPiece=NONE);
+	struct Gamestate;
 
-	std::string toAN() const;
-	std::string toString() const;
+	// Move packed in 16 bits, from:6 | to:6 | flags:4, passed by value
+	// Squares are numbered rank*8 + file, like the bitboards
+	struct Action
+	{
+		enum Flag : uint16_t
+		{
+			NORMAL = 0,
+			CASTLE = 1,
+			PASSANT = 2,
+			// Plus the type of the new piece minus KNIGHT
+			PROMOTION = 4
+		};
 
-	bool operator ==(const Action& b) const;
-};
+		uint16_t data;
 
-struct Castle
-{
-	bool kingside:1;
-	bool queenside:1;
+		Action() = default;
+		constexpr Action(unsigned int from, unsigned int to, unsigned int flags=NORMAL)
+			: data(static_cast<uint16_t>(from | to << 6 | flags << 12)) {}
+		Action(Coordinate from, Coordinate to, unsigned int flags=NORMAL)
+			: Action(from.square(), to.square(), flags) {}
 
-	inline bool canCastle() const { return kingside || queenside; }
-};
+		static constexpr unsigned int promotionFlag(Piece type) { return PROMOTION + type - KNIGHT; }
 
-struct Gamestate
-{
-	// Consider changing to int:1, and do some shift magic in trees
-	bool whiteToMove;
-	Board board;
-	Castle whiteCastle;
-	Castle blackCastle;
-	Coordinate passantSquare;
-	uint8_t rule50Ply; // Can not exceed 150
-
-	Gamestate(std::string FEN);
-	Gamestate();
-
-	std::string toFEN() const;
-	inline std::string toString() const { return toFEN(); }
-};
-
-struct ChildNode
-{
-	Gamestate* gamestate;
-	Action* action;
-	float score; /* Relative move score used for move ordering */
-};
+		inline unsigned int fromSquare() const { return data & 0x3f; }
+		inline unsigned int toSquare() const { return data >> 6 & 0x3f; }
+		inline unsigned int flags() const { return data >> 12; }
 
-inline bool operator<(const ChildNode& a, const ChildNode& b)
-{
-	return a.score < b.score;
+		inline Coordinate from() const { return Coordinate::fromSquare(fromSquare()); }
+		inline Coordinate to() const { return Coordinate::fromSquare(toSquare()); }
+
+		inline bool isCastle() const { return flags() == CASTLE; }
+		inline bool isPassant() const { return flags() == PASSANT; }
+		inline bool isPromotion() const { return flags() >= PROMOTION; }
+		// Type of the new piece of a promotion, NONE otherwise
+		inline Piece promotionPiece() const { return isPromotion() ? static_cast<Piece>(KNIGHT + flags() - PROMOTION) : Piece{NONE}; }
+
+		// Read a move in algebraic notation, such as e7e8q, played in `state`
+		static Action fromAN(const std::string& AN, const Gamestate& state);
+		std::string toAN() const;
+		std::string toString() const;
+
+		inline bool operator ==(const Action& b) const { return data == b.data; }
+	};
+
+	// Castling rights, one bit per player and side, as indexed in ZOBRIST.castle
+	enum CastlingRight : uint8_t
+	{
+		WHITE_KINGSIDE = 1,
+		WHITE_QUEENSIDE = 2,
+		BLACK_KINGSIDE = 4,
+		BLACK_QUEENSIDE = 8
+	};
+
+	inline constexpr uint8_t kingsideRight(Color c) { return c == WHITE ? WHITE_KINGSIDE : BLACK_KINGSIDE; }
+	inline constexpr uint8_t queensideRight(Color c) { return c == WHITE ? WHITE_QUEENSIDE : BLACK_QUEENSIDE; }
+
+	// passantSquare when the last move wasn't a pawn moving two steps
+	constexpr uint8_t NO_SQUARE = 64;
+
+	// Aligned, so copying or probing a gamestate touches a single cache line
+	struct alignas(64) Gamestate
+	{
+		Board board;
+		bool whiteToMove;
+		// Castling rights that are left, see CastlingRight
+		uint8_t castling;
+		// Square the last move's pawn passed moving two steps, or NO_SQUARE
+		uint8_t passantSquare;
+		uint8_t rule50Ply; // Can not exceed 150
+
+		Gamestate(std::string_view FEN);
+		Gamestate();
+
+		std::string toFEN() const;
+		inline std::string toString() const { return toFEN(); }
+	};
+
+	// Copied for every child of the root, and by each search thread
+	static_assert(sizeof(Gamestate) == 64, "Gamestate should fit in a cache line");
+
+	struct ScoredAction
+	{
+		Action action;
+		float score; /* Relative move score used for move ordering */
+		float see; /* Material won by a capture from the move picker once the exchange is played out */
+	};
+
+	inline bool operator>(const ScoredAction& a, const ScoredAction& b)
+	{
+		return a.score > b.score;
+	}
+
+	// What makeMove can't derive back from the new gamestate and the action
+	struct Undo
+	{
+		Piece captured;
+		uint8_t castling;
+		uint8_t passantSquare;
+		uint8_t rule50Ply;
+	};
+
+	// Play `action` on `state` in place, with all its side effects
+	void makeMove(Gamestate& state, const Action& action, Undo& undo);
+	// Take back `action`, leaving `state` as it was before makeMove
+	void unmakeMove(Gamestate& state, const Action& action, const Undo& undo);
+
+	// Game policy for the search, see game.h
+	struct Chess
+	{
+		using State = Gamestate;
+		using Action = chess::Action;
+
+		static bool whiteToMove(State const* statep) { return statep->whiteToMove; }
+
+		static void deleteState(State* statep) { delete statep; }
+		static void deleteAction(Action* actionp) { delete actionp; }
+
+		static void genChildren(State const* statep, std::vector<State*>& states, std::vector<Action*>& actions);
+
+		static void initActions(State const* statep, uint16_t hashAction, float maxLoss, unsigned int ply);
+		static void initCaptures(State const* statep, float minGain, unsigned int ply);
+		static Action const* nextAction(unsigned int ply);
+
+		static void makeMove(State& state, Action const* actionp, unsigned int ply);
+		static void unmakeMove(State& state, Action const* actionp, unsigned int ply);
+		static bool makeNullMove(State& state, unsigned int ply);
+		static void unmakeNullMove(State& state, unsigned int ply);
+
+		static float evaluation(State const* statep);
+		static uint64_t hashState(State const* statep);
+
+		static uint16_t actionKey(Action const* actionp)
+		{
+			// The packed move, from:6 | to:6 | flags:4
+			return actionp->data;
+		}
+
+		static bool isQuiet(State const* statep, Action const* actionp)
+		{
+			// En passant captures on an empty square
+			return !actionp->isPassant() && !actionp->isPromotion() &&
+				!(statep->board.occupancy() & squareBB(actionp->toSquare()));
+		}
+	};
+
+	// How chess move generation keeps moves from leaving the king in check
+	enum class MoveGeneration
+	{
+		// Pins and attacked squares are found before generating, so only legal
+		// moves are generated
+		LEGAL,
+		// Only checks are found before generating, and moves of pinned pieces
+		// and the king are checked as nextAction reaches them, so after a
+		// cutoff the rest never are
+		PSEUDO_LEGAL
+	};
+
+	// Used by all search threads, only change it while no search is running
+	void setMoveGeneration(MoveGeneration generation);
+	MoveGeneration getMoveGeneration();
+
+	// Append all legal actions of the gamestate to `actions`, in generation order
+	// Unlike during the search, the 75 move rule doesn't end the game
+	void genLegalActions(Gamestate const* statep, std::vector<ScoredAction>& actions);
 }
+
 #endif
@@ -0,0 +1,54 @@
+#ifndef CHESS_ZOBRIST_H_INCLUDED
+#define CHESS_ZOBRIST_H_INCLUDED
+
+#include <cstdint>
+
+namespace chess
+{
+	// Random keys for Zobrist hashing, generated at compile time
+	// The key of a gamestate is the xor of the keys of all its features
+	struct ZobristKeys
+	{
+		uint64_t pieces[16][64]; /* Indexed by piece and square */
+		uint64_t whiteToMove;
+		uint64_t castle[16]; /* Indexed by the castling rights as a bitmask */
+		uint64_t passantFile[8];
+	};
+
+	constexpr uint64_t splitmix64(uint64_t& state)
+	{
+		uint64_t z = (state += 0x9e3779b97f4a7c15);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		return z ^ (z >> 31);
+	}
+
+	constexpr ZobristKeys genZobristKeys()
+	{
+		ZobristKeys keys {};
+		uint64_t state = 0x7468696e63636263;
+
+		for (unsigned int piece=0; piece<16; piece++) {
+			// Empty squares don't change the key
+			if ((piece & 7) == 0)
+				continue;
+			for (unsigned int square=0; square<64; square++)
+				keys.pieces[piece][square] = splitmix64(state);
+		}
+
+		keys.whiteToMove = splitmix64(state);
+
+		// No castling rights don't change the key
+		for (unsigned int rights=1; rights<16; rights++)
+			keys.castle[rights] = splitmix64(state);
+
+		for (unsigned int file=0; file<8; file++)
+			keys.passantFile[file] = splitmix64(state);
+
+		return keys;
+	}
+
+	inline constexpr ZobristKeys ZOBRIST = genZobristKeys();
+}
+
+#endif
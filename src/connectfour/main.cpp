@@ -6,8 +6,7 @@
 #include "../trees.h"
 #include "../game.h"
 
-bool gameOver(Gamestate const*);
-float evaluation(Gamestate const*);
+using namespace connectfour;
 
 int main() {
 	Gamestate* sp = new Gamestate();
@@ -16,10 +15,11 @@ int main() {
 	bool player = true;
 	unsigned int ply = 0;
 
-	Evaluation e = bestAction(sp, depth);
+	Evaluation<ConnectFour> e = bestAction<ConnectFour>(sp, depth);
 	std::cout <<
 		"Best action is:\t" << e.action->toString() << std::endl <<
-		"Evaluation:\t" << e.evaluation << std::endl;
+		"Evaluation:\t" << e.evaluation << std::endl <<
+		"Nodes searched:\t" << searchedNodes() << std::endl;
 
 	delete e.action;
 
@@ -29,16 +29,16 @@ int main() {
 	std::vector<Action*> actions;
 
 	while (!gameOver(sp)) {
-		genChildren(sp, states, actions);
+		ConnectFour::genChildren(sp, states, actions);
 
 		unsigned int column;
 
-		std::cout << "Current state evaluation:\t" << evaluation(sp) << std::endl;
+		std::cout << "Current state evaluation:\t" << ConnectFour::evaluation(sp) << std::endl;
 		if (player && sp->yellowToMove) {
 			// No input-validation
 			std::cin >> column;
 		} else {
-			e = bestAction(sp, depth);
+			e = bestAction<ConnectFour>(sp, depth);
 			column = e.action->column;
 			std::cout << "Node evaluation:\t" << e.evaluation << std::endl;
 		}
@@ -65,5 +65,5 @@ int main() {
 		std::cout << "Ply: " << ++ply << std::endl;
 	}
 	std::cout << e.evaluation << std::endl;
-	std::cout << evaluation(sp) << std::endl;
+	std::cout << ConnectFour::evaluation(sp) << std::endl;
 }
@@ -1,32 +1,83 @@
-#ifndef STATES_H_INCLUDED
-#define STATES_H_INCLUDED
+#ifndef CONNECTFOUR_STATES_H_INCLUDED
+#define CONNECTFOUR_STATES_H_INCLUDED
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
-struct Action
+#include "../game.h"
+
+namespace connectfour
 {
-	unsigned int column;
+	struct Action
+	{
+		unsigned int column;
 
-	std::string toString();
-};
+		std::string toString();
+	};
 
-struct Column
-{
-	int8_t stack[6]; // yellow = 1, blank = 0, red = -1
+	struct Column
+	{
+		int8_t stack[6]; // yellow = 1, blank = 0, red = -1
 
-	bool isFull() const;
-	void drop(int8_t color);
-};
+		bool isFull() const;
+		void drop(int8_t color);
+		void pop();
+	};
 
-struct Gamestate
-{
-	bool yellowToMove;
-	Column columns[7];
+	struct Gamestate
+	{
+		bool yellowToMove;
+		Column columns[7];
+
+		Gamestate(bool yellowToMove=true);
+		Gamestate(bool yellowToMove, Column columns[7]);
+
+		std::string toString();
+	};
+
+	// Whether the game is won or the board is full
+	bool gameOver(Gamestate const* statep);
+
+	// Game policy for the search, see game.h
+	struct ConnectFour : ActionStack<ConnectFour, Gamestate, Action>
+	{
+		using State = Gamestate;
+		using Action = connectfour::Action;
+
+		static bool whiteToMove(State const* statep) { return statep->yellowToMove; }
+
+		static void deleteState(State* statep) { delete statep; }
+		static void deleteAction(Action* actionp) { delete actionp; }
+
+		static void genActions(State const* statep, std::vector<Action>& actions);
 
-	Gamestate(bool yellowToMove=true);
-	Gamestate(bool yellowToMove, Column columns[7]);
+		static void makeMove(State& state, Action const* actionp, unsigned int)
+		{
+			state.columns[actionp->column].drop(state.yellowToMove ? 1 : -1);
+			state.yellowToMove = !state.yellowToMove;
+		}
+		static void unmakeMove(State& state, Action const* actionp, unsigned int)
+		{
+			state.columns[actionp->column].pop();
+			state.yellowToMove = !state.yellowToMove;
+		}
+		static bool makeNullMove(State&, unsigned int)
+		{
+			// Zugzwang is common, so passing would prune wrongly
+			return false;
+		}
+		static void unmakeNullMove(State&, unsigned int) {}
 
-	std::string toString();
-};
+		static float evaluation(State const* statep);
+		static uint64_t hashState(State const* statep);
+		static uint16_t actionKey(Action const* actionp) { return actionp->column; }
+		static bool isQuiet(State const*, Action const*)
+		{
+			// Nothing is ever captured
+			return true;
+		}
+	};
+}
 
 #endif
@@ -3,15 +3,154 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 
-struct Action;
-struct Gamestate;
+// The search in trees.h is a template over a game policy: a type with the
+// member types and static functions below, declared by each game next to its
+// gamestate. Small functions can be defined in the class, so they are
+// inlined into the search.
+//
+// using State
+// using Action
+//
+// Whether the player that positive evaluations are good for is to move
+// static bool whiteToMove(State const* statep);
+//
+// static void deleteState(State* statep);
+// static void deleteAction(Action* actionp);
+//
+// Children of the gamestate, best first, used at the root
+// static void genChildren(State const* statep, std::vector<State*>& states, std::vector<Action*>& actions);
+//
+// In-place interface used by the search below the root
+// Actions are kept by the game per thread and per ply, and stay valid until
+// actions are generated again at the same ply on the same thread
+//
+// Start going through the actions of the gamestate, the action with key
+// `hashAction` first if it is legal. Actions may be generated lazily, as
+// nextAction reaches them
+// Actions expected to lose more than `maxLoss`, like captures of defended
+// pieces, may be skipped, as long as another action is returned
+// static void initActions(State const* statep, uint16_t hashAction, float maxLoss, unsigned int ply);
+//
+// Start going through the actions that capture or promote instead, searched
+// by the quiescence search until the gamestate is quiet
+// Actions that can't improve the evaluation by at least `minGain` may be skipped
+// static void initCaptures(State const* statep, float minGain, unsigned int ply);
+//
+// Next action at `ply`, best first, or nullptr when there are no more
+// static Action const* nextAction(unsigned int ply);
+//
+// Play the action on the gamestate, keeping what is needed to take it back at `ply`
+// static void makeMove(State& state, Action const* actionp, unsigned int ply);
+// static void unmakeMove(State& state, Action const* actionp, unsigned int ply);
+//
+// Let the player to move pass, used for null move pruning
+// Returns false and leaves the gamestate untouched when passing would give a
+// wrong idea of the gamestate, like in check or zugzwang, or when the game has
+// no such notion
+// static bool makeNullMove(State& state, unsigned int ply);
+// static void unmakeNullMove(State& state, unsigned int ply);
+//
+// Evaluation from the perspective of white, 100/-100 when the game is won/lost
+// static float evaluation(State const* statep);
+//
+// Key identifying the gamestate in the transposition table
+// Equal states must have equal keys
+// static uint64_t hashState(State const* statep);
+//
+// Key identifying an action among the children of a gamestate
+// Must differ from NO_ACTION
+// static uint16_t actionKey(Action const* actionp);
+//
+// Whether the action neither captures nor promotes
+// Only quiet actions are remembered by the move ordering heuristics below
+// static bool isQuiet(State const* statep, Action const* actionp);
 
-void deleteState(Gamestate* state);
-void deleteAction(Action* action);
+// Key of no action, such as when no best action is known
+constexpr uint16_t NO_ACTION = 0xffff;
 
-void genChildren(Gamestate const* statep, std::vector<Gamestate*>& gamestates, std::vector<Action*>& actions);
+// Implements genChildren and the in-place interface for games that generate
+// every action of a gamestate at once and never capture. The game policy
+// derives from ActionStack<Policy, State, Action> and supplies
+//
+// Actions of the gamestate, best first, none when the game is over
+// static void genActions(State const* statep, std::vector<Action>& actions);
+template <typename Game, typename State, typename Action>
+class ActionStack
+{
+	struct ActionList
+	{
+		std::vector<Action> actions;
+		unsigned int next;
+	};
+	// Actions of the in-place interface, per thread and indexed by ply
+	inline static thread_local std::vector<ActionList> stack;
 
-float evaluation(Gamestate const* statep);
+	static std::vector<Action>& clearActions(unsigned int ply)
+	{
+		if (ply >= stack.size())
+			stack.resize(ply + 1);
+		stack[ply].actions.clear();
+		stack[ply].next = 0;
+		return stack[ply].actions;
+	}
+
+public:
+	static void genChildren(State const* statep, std::vector<State*>& states, std::vector<Action*>& actions)
+	{
+		std::vector<Action> moves;
+		Game::genActions(statep, moves);
+
+		for (const Action& move : moves) {
+			actions.push_back(new Action{move});
+			State* childp = new State{*statep};
+			states.push_back(childp);
+			Game::makeMove(*childp, &move, 0);
+		}
+	}
+
+	static void initActions(State const* statep, uint16_t hashAction, float, unsigned int ply)
+	{
+		std::vector<Action>& actions = clearActions(ply);
+		Game::genActions(statep, actions);
+
+		// Search the hash action first, and the others in generation order
+		for (auto it = actions.begin(); it != actions.end(); it++) {
+			if (Game::actionKey(&*it) == hashAction) {
+				std::rotate(actions.begin(), it, it + 1);
+				break;
+			}
+		}
+	}
+
+	static void initCaptures(State const*, float, unsigned int ply)
+	{
+		// Every gamestate is quiet
+		clearActions(ply);
+	}
+
+	static Action const* nextAction(unsigned int ply)
+	{
+		ActionList& list = stack[ply];
+		if (list.next >= list.actions.size())
+			return nullptr;
+		return &list.actions[list.next++];
+	}
+};
+
+// Move ordering heuristics, implemented by the search in trees.cpp
+// May be used by initActions and nextAction to order quiet actions
+
+constexpr unsigned int KILLER_SLOTS = 2;
+
+// Key of a quiet action that caused a cutoff in a gamestate at `ply`, most
+// recent in slot 0, or NO_ACTION
+uint16_t killerAction(unsigned int ply, unsigned int slot);
+
+// How much the action has caused cutoffs in recent searches, in [0, 1)
+// Actions are identified by the lower 12 bits of their key, such as the from/to squares in chess
+float historyScore(uint16_t key);
 
 #endif
@@ -0,0 +1,34 @@
+#include <iostream>
+#include <string>
+
+#include "../ball/states.h"
+#include "../tictactoe/states.h"
+#include "../connectfour/states.h"
+#include "../chess/states.h"
+#include "../trees.h"
+#include "../game.h"
+
+// Every game linked into one binary, to check that their gamestates,
+// actions and helpers don't collide. Each game is searched from its start
+
+template <typename Game>
+void searchStart(const std::string& name, typename Game::State const* statep, unsigned int depth)
+{
+	Evaluation<Game> e = bestAction<Game>(statep, depth);
+	std::cout << name << ":\t" << e.action->toString() << "\t" << e.evaluation << std::endl;
+	Game::deleteAction(e.action);
+}
+
+int main() {
+	ball::Gamestate ballState {true, 0, 0, 0, 0};
+	searchStart<ball::Ball>("ball", &ballState, 15);
+
+	tictactoe::Gamestate tictactoeState {true, {0, 0, 0, 0, 0, 0, 0, 0, 0}};
+	searchStart<tictactoe::TicTacToe>("tictactoe", &tictactoeState, 9);
+
+	connectfour::Gamestate connectfourState;
+	searchStart<connectfour::ConnectFour>("connectfour", &connectfourState, 7);
+
+	chess::Gamestate chessState;
+	searchStart<chess::Chess>("chess", &chessState, 5);
+}
@@ -5,18 +5,18 @@
 #include "../trees.h"
 #include "../game.h"
 
-bool gameOver(Gamestate const*);
+using namespace tictactoe;
 
 int main() {
 	Gamestate* sp = new Gamestate{true, {0, 0, 0, 0, 0, 0, 0, 0, 0}};
 
 	std::cerr << "Current state:" << std::endl << sp->toString() << "\n" << std::endl;
-	std::cerr << evaluation(sp);
+	std::cerr << TicTacToe::evaluation(sp);
 
 	unsigned int depth = 15;
 	bool player = true;
 
-	Evaluation e = bestAction(sp, depth);
+	Evaluation<TicTacToe> e = bestAction<TicTacToe>(sp, depth);
 	std::cout <<
 		"Best action is:\t" << e.action->toString() << std::endl <<
 		"Evaluation:\t" << e.evaluation << std::endl;
@@ -28,7 +28,7 @@ int main() {
 
 	std::cout << sp->toString();
 	while (!gameOver(sp)) {
-		genChildren(sp, states, actions);
+		TicTacToe::genChildren(sp, states, actions);
 
 		unsigned int x, y;
 
@@ -36,7 +36,7 @@ int main() {
 			// No input-validation
 			std::cin >> x >> y;
 		} else {
-			e = bestAction(sp, depth);
+			e = bestAction<TicTacToe>(sp, depth);
 			x = e.action->x;
 			y = e.action->y;
 		}
@@ -1,21 +1,71 @@
-#ifndef STATES_H_INCLUDED
-#define STATES_H_INCLUDED
+#ifndef TICTACTOE_STATES_H_INCLUDED
+#define TICTACTOE_STATES_H_INCLUDED
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
-struct Action
+#include "../game.h"
+
+namespace tictactoe
 {
-	unsigned int x, y;
+	struct Action
+	{
+		unsigned int x, y;
 
-	std::string toString();
-};
+		std::string toString();
+	};
 
-struct Gamestate
-{
-	bool xToMove;
-	int8_t board[9]; // X = 1, blank = 0, O = -1
+	struct Gamestate
+	{
+		bool xToMove;
+		int8_t board[9]; // X = 1, blank = 0, O = -1
+
+		std::string toString();
+	};
+
+	// Whether the game is won or the board is full
+	bool gameOver(Gamestate const* statep);
+
+	// Game policy for the search, see game.h
+	struct TicTacToe : ActionStack<TicTacToe, Gamestate, Action>
+	{
+		using State = Gamestate;
+		using Action = tictactoe::Action;
+
+		static bool whiteToMove(State const* statep) { return statep->xToMove; }
+
+		static void deleteState(State* statep) { delete statep; }
+		static void deleteAction(Action* actionp) { delete actionp; }
+
+		static void genActions(State const* statep, std::vector<Action>& actions);
+
+		static void makeMove(State& state, Action const* actionp, unsigned int)
+		{
+			state.board[actionp->y*3 + actionp->x] = state.xToMove ? 1 : -1;
+			state.xToMove = !state.xToMove;
+		}
+		static void unmakeMove(State& state, Action const* actionp, unsigned int)
+		{
+			state.board[actionp->y*3 + actionp->x] = 0;
+			state.xToMove = !state.xToMove;
+		}
+		static bool makeNullMove(State&, unsigned int)
+		{
+			// The whole tree is searched, so nothing is gained by pruning
+			return false;
+		}
+		static void unmakeNullMove(State&, unsigned int) {}
 
-	std::string toString();
-};
+		static float evaluation(State const* statep);
+		static uint64_t hashState(State const* statep);
+		static uint16_t actionKey(Action const* actionp) { return actionp->y*3 + actionp->x; }
+		static bool isQuiet(State const*, Action const*)
+		{
+			// Nothing is ever captured
+			return true;
+		}
+	};
+}
 
 #endif
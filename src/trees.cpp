@@ -1,76 +1,151 @@
 #include "trees.h"
 
-#include <string>
-#include <cmath>
 #include <algorithm>
-#include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <iterator>
 
 #include "game.h"
+#include "tt.h"
 
-Evaluation bestAction(Gamestate const* statep, unsigned int depth)
+namespace search
 {
-	// State must not be terminal
-	float value;
-	float childValue;
-	Action* action = nullptr;
-
-	std::vector<Gamestate*> states;
-	std::vector<Action*> actions;
-
-	// Generate children of root node
-	genChildren(statep, states, actions);
-
-	value = -INFINITY;
-	for (unsigned int i=0; i<states.size(); i++) {
-		childValue = -negamax(states[i], depth - 1, -INFINITY, INFINITY);
-		if (childValue > value) {
-			// New best action
-			value = childValue;
-			if (action) {
-				deleteAction(action);
-			}
-			action = actions[i];
-		} else {
-			deleteAction(actions[i]);
-		}
-		deleteState(states[i]);
+	TranspositionTable tt;
+	std::atomic<bool> stopSearch {false};
+	std::atomic<uint64_t> totalNodes {0};
+	unsigned int searchThreads = 1;
+
+	SearchLimits searchLimits;
+	std::chrono::steady_clock::time_point searchStart;
+
+	thread_local uint64_t nodes = 0;
+	thread_local bool enforceLimits = false;
+
+	namespace
+	{
+		// Move ordering heuristics of this thread, see killerAction and historyScore
+		// Killer actions are quiet actions that caused a cutoff at the same ply
+		thread_local uint16_t killers[MAX_DEPTH + 1][KILLER_SLOTS];
+		// Indexed by the lower 12 bits of the action key
+		thread_local uint32_t history[1 << 12];
+
+		// History values are halved when one reaches this, so old cutoffs count less
+		constexpr uint32_t HISTORY_MAX = 1 << 16;
 	}
 
-	if (!action)
-		throw std::runtime_error("Terminal state given to bestAction");
+	float valueFromTT(float value, unsigned int storedDepth, unsigned int depth)
+	{
+		// Won/lost values include the remaining depth at the terminal node,
+		// so they must be shifted when the node is reached with a different depth
+		if (value >= WIN_VALUE)
+			return value - (storedDepth - depth);
+		else if (value <= -WIN_VALUE)
+			return value + (storedDepth - depth);
+		return value;
+	}
 
-	return { action, value };
-}
+	void resetOrdering()
+	{
+		for (auto& slots : killers)
+			std::fill(std::begin(slots), std::end(slots), NO_ACTION);
 
-float negamax(Gamestate const* statep, unsigned int depth, float alpha, float beta)
-{
-	std::vector<Gamestate*> states;
-	std::vector<Action*> actions;
-
-	if (depth == 0 || (genChildren(statep, states, actions), states.size() == 0)) {
-		float eval = evaluation(statep);
-		int sign = *reinterpret_cast<bool const*>(statep) ? 1 : -1;
-		// Weigh won/lost nodes by distance to emulate human play
-		// Gamestates must store `bool whiteToMove` as their first member
-		if (eval == 100)
-			return sign * (eval + depth);
-		else if (eval == -100)
-			return sign * (eval - depth);
-		else
-			return sign * eval;
+		// Keep some history from earlier searches
+		for (uint32_t& value : history)
+			value /= 2;
 	}
 
-	for (Action* nextAction : actions)
-		deleteAction(nextAction);
+	void updateOrdering(uint16_t key, unsigned int depth, unsigned int ply)
+	{
+		// The quiet action with the given key caused a cutoff
+		if (ply <= MAX_DEPTH && killers[ply][0] != key) {
+			std::copy_backward(killers[ply], killers[ply] + KILLER_SLOTS - 1, killers[ply] + KILLER_SLOTS);
+			killers[ply][0] = key;
+		}
 
-	float value = -INFINITY;
-	for (Gamestate* nextState : states) {
-		if (alpha < beta) {
-			value = std::max(value, -negamax(nextState, depth - 1, -beta, -alpha));
-			alpha = std::max(alpha, value);
+		// Cutoffs far from the leaves save more nodes
+		uint32_t& value = history[key & 0xfff];
+		value += depth * depth;
+		if (value >= HISTORY_MAX) {
+			for (uint32_t& v : history)
+				v /= 2;
 		}
-		deleteState(nextState);
 	}
-	return value;
+
+	std::chrono::milliseconds elapsed()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - searchStart);
+	}
+
+	bool skipDepth(unsigned int thread, unsigned int depth)
+	{
+		// Helper n skips depths in alternating runs of SKIP_SIZE[n], shifted
+		// by SKIP_PHASE[n], so each depth is searched by about half the helpers
+		// and they don't all finish iterations at the same time
+		constexpr unsigned int SKIP_PATTERNS = 20;
+		constexpr unsigned int SKIP_SIZE[SKIP_PATTERNS] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+		constexpr unsigned int SKIP_PHASE[SKIP_PATTERNS] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+		if (thread == 0)
+			// The main thread searches every depth
+			return false;
+		unsigned int pattern = (thread - 1) % SKIP_PATTERNS;
+		return (depth + SKIP_PHASE[pattern]) / SKIP_SIZE[pattern] % 2 == 1;
+	}
+
+	void checkLimits()
+	{
+		// Report nodes so the node limit counts the nodes of all threads
+		totalNodes += nodes;
+		nodes = 0;
+
+		if (!enforceLimits)
+			return;
+
+		if (searchLimits.nodes != 0 && totalNodes >= searchLimits.nodes)
+			stopSearch = true;
+
+		if (searchLimits.time.count() != 0 && elapsed() >= searchLimits.time)
+			stopSearch = true;
+	}
 }
 
+void setSearchThreads(unsigned int threads)
+{
+	search::searchThreads = std::max(threads, 1u);
+}
+
+unsigned int getSearchThreads()
+{
+	return search::searchThreads;
+}
+
+void setHashSize(size_t megabytes)
+{
+	search::tt.resize(megabytes);
+}
+
+void clearHash()
+{
+	search::tt.clear();
+	// Helper threads start every search without history
+	std::fill(std::begin(search::history), std::end(search::history), 0);
+}
+
+uint64_t searchedNodes()
+{
+	return search::totalNodes;
+}
+
+uint16_t killerAction(unsigned int ply, unsigned int slot)
+{
+	using namespace search;
+	if (ply > MAX_DEPTH)
+		return NO_ACTION;
+	return killers[ply][slot];
+}
+
+float historyScore(uint16_t key)
+{
+	using namespace search;
+	return static_cast<float>(history[key & 0xfff]) / HISTORY_MAX;
+}
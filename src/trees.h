@@ -2,16 +2,478 @@
 #define TREES_H_INCLUDED
 
 #include "game.h"
+#include "tt.h"
 
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+// The search is a template over a game policy `Game`, see game.h, so it is
+// compiled for each game and small game functions can be inlined into it
+
+template <typename Game>
 struct Evaluation
 {
-	Action* action;
+	typename Game::Action* action;
 	float evaluation;
+	unsigned int depth; /* Depth of the last completed iteration */
+};
+
+// Limits for bestAction, zero means no limit
+// The search stops at whichever limit is reached first
+struct SearchLimits
+{
+	unsigned int depth = 0;
+	std::chrono::milliseconds time {0};
+	uint64_t nodes = 0;
 };
 
-void genChildren(Gamestate const* statep, std::vector<Gamestate*>& states, std::vector<Action*>& actions);
+// Amount of threads used by bestAction (lazy SMP), at least 1
+void setSearchThreads(unsigned int threads);
+unsigned int getSearchThreads();
+
+// Size of the transposition table shared by all threads
+void setHashSize(size_t megabytes);
+
+// Forget all stored search results, and the move ordering history
+// Needed before searching a different game, since keys are only unique within a game
+void clearHash();
+
+// Nodes searched by the last call to bestAction, summed over all threads
+uint64_t searchedNodes();
+
+// Iterative deepening search, returning the best action of the last
+// completed iteration
+template <typename Game>
+Evaluation<Game> bestAction(typename Game::State const* statep, const SearchLimits& limits);
+template <typename Game>
+Evaluation<Game> bestAction(typename Game::State const* statep, unsigned int depth);
+
+
+// Implementation, the parts that don't depend on the game are in trees.cpp
+namespace search
+{
+	// Shared by all search threads
+	extern TranspositionTable tt;
+	extern std::atomic<bool> stopSearch;
+	extern std::atomic<uint64_t> totalNodes;
+	extern unsigned int searchThreads;
+
+	// Limits of the running search, only enforced by the main thread
+	extern SearchLimits searchLimits;
+	extern std::chrono::steady_clock::time_point searchStart;
+
+	// Nodes searched by this thread since it last reported to totalNodes
+	extern thread_local uint64_t nodes;
+
+	// Set in the main thread once its first iteration is completed, so there
+	// is always a result to return
+	extern thread_local bool enforceLimits;
+
+	// Nodes between each report to totalNodes and check of the limits
+	constexpr uint64_t CHECK_INTERVAL = 1024;
+
+	// Depth searched to when there is no depth limit
+	// Must be below 256, since depths are stored modulo 256 in the transposition table
+	constexpr unsigned int MAX_DEPTH = 128;
+
+	// Evaluations at or beyond this are won/lost nodes weighted by distance
+	constexpr float WIN_VALUE = 100;
+
+	// Margin added to the largest possible gain of a capture in quiescence
+	// search, to account for positional changes
+	constexpr float DELTA_MARGIN = 2;
+
+	// Actions that lose material are skipped at this depth and below, when
+	// they lose more than LOSS_MARGIN per ply above depth 1
+	constexpr unsigned int LOSS_PRUNING_DEPTH = 2;
+	constexpr float LOSS_MARGIN = 1;
+
+	// Null move pruning is done at this depth and above. The null move is
+	// searched NULL_MOVE_REDUCTION plies shallower, one more from NULL_MOVE_DEEP_DEPTH
+	constexpr unsigned int NULL_MOVE_MIN_DEPTH = 3;
+	constexpr unsigned int NULL_MOVE_REDUCTION = 2;
+	constexpr unsigned int NULL_MOVE_DEEP_DEPTH = 7;
+
+	// Late move reductions are done at this depth and above, for the quiet
+	// actions ordered after the first LMR_MIN_INDEX
+	// From LMR_DEEP_INDEX, and at LMR_DEEP_DEPTH and above, they are reduced by another ply
+	constexpr unsigned int LMR_MIN_DEPTH = 3;
+	constexpr unsigned int LMR_MIN_INDEX = 3;
+	constexpr unsigned int LMR_DEEP_DEPTH = 6;
+	constexpr unsigned int LMR_DEEP_INDEX = 6;
+
+	// Initial distance from the previous value to the bounds of the aspiration window
+	constexpr float ASPIRATION_WINDOW = 0.5;
+
+	float valueFromTT(float value, unsigned int storedDepth, unsigned int depth);
+	void resetOrdering();
+	void updateOrdering(uint16_t key, unsigned int depth, unsigned int ply);
+	std::chrono::milliseconds elapsed();
+	// Whether search thread `thread` skips the iteration at `depth`, the main thread is 0
+	bool skipDepth(unsigned int thread, unsigned int depth);
+	void checkLimits();
+
+	// Upper bound of a null window above alpha. A search with this window only
+	// proves whether the value is above or below alpha
+	inline float nullWindow(float alpha)
+	{
+		return std::nextafter(alpha, INFINITY);
+	}
+
+	template <typename Game>
+	float leafValue(typename Game::State const* statep, unsigned int depth)
+	{
+		// Evaluation from the perspective of the player to move
+		float eval = Game::evaluation(statep);
+		int sign = Game::whiteToMove(statep) ? 1 : -1;
+		// Weigh won/lost nodes by distance to emulate human play
+		if (eval == 100)
+			return sign * (eval + depth);
+		else if (eval == -100)
+			return sign * (eval - depth);
+		else
+			return sign * eval;
+	}
+
+	template <typename Game>
+	float quiescence(typename Game::State* statep, float alpha, float beta, unsigned int ply)
+	{
+		// Search captures and promotions until the gamestate is quiet, so it
+		// isn't evaluated in the middle of an exchange
+		if (stopSearch.load(std::memory_order_relaxed))
+			return 0;
+
+		if (++nodes >= CHECK_INTERVAL)
+			checkLimits();
+
+		// Stand pat: the player to move is assumed to have a move at least as
+		// good as the evaluation, so it is a lower bound on the value
+		float value = leafValue<Game>(statep, 0);
+		if (value >= beta || std::abs(value) >= WIN_VALUE)
+			return value;
+		alpha = std::max(alpha, value);
+
+		// Delta pruning: skip captures that can't raise the value to alpha
+		Game::initCaptures(statep, alpha - value - DELTA_MARGIN, ply);
+
+		typename Game::Action const* actionp;
+		while (alpha < beta && (actionp = Game::nextAction(ply))) {
+			Game::makeMove(*statep, actionp, ply);
+			float childValue = -quiescence<Game>(statep, -beta, -alpha, ply + 1);
+			Game::unmakeMove(*statep, actionp, ply);
+
+			value = std::max(value, childValue);
+			alpha = std::max(alpha, value);
+		}
+
+		return value;
+	}
+
+	template <typename Game>
+	float negamax(typename Game::State* statep, unsigned int depth, float alpha, float beta, unsigned int ply, bool allowNull=true)
+	{
+		// The gamestate is played on in place, and is restored before returning
+		if (depth == 0)
+			return quiescence<Game>(statep, alpha, beta, ply);
+
+		if (stopSearch.load(std::memory_order_relaxed))
+			// The result is discarded by the caller
+			return 0;
+
+		if (++nodes >= CHECK_INTERVAL)
+			checkLimits();
+
+		// Leaves are not stored, so only interior nodes are looked up
+		uint64_t key = Game::hashState(statep);
+		uint16_t hashAction = NO_ACTION;
+		TTEntry entry;
+		if (tt.probe(key, entry)) {
+			if (entry.depth >= depth) {
+				float value = valueFromTT(entry.value, entry.depth, depth);
+				if (entry.bound == Bound::EXACT ||
+					(entry.bound == Bound::LOWER && value >= beta) ||
+					(entry.bound == Bound::UPPER && value <= alpha))
+					return value;
+			}
+			hashAction = entry.action;
+		}
+
+		// Null move pruning: if passing still fails high, a real move almost
+		// certainly will too. Only done in null windows, where nodes are expected
+		// to fail high or low, and never twice in a row. Passing can't prove a
+		// win, so it isn't tried when only a win fails high
+		if (allowNull && depth >= NULL_MOVE_MIN_DEPTH && beta == nullWindow(alpha) && beta < WIN_VALUE &&
+			Game::makeNullMove(*statep, ply)) {
+			unsigned int reduction = NULL_MOVE_REDUCTION + (depth >= NULL_MOVE_DEEP_DEPTH);
+			float nullValue = -negamax<Game>(statep, depth - 1 - reduction, -beta, -alpha, ply + 1, false);
+			Game::unmakeNullMove(*statep, ply);
+
+			if (nullValue >= beta && !stopSearch.load(std::memory_order_relaxed))
+				// Won values are not proven when a player passed, so the
+				// bound is returned instead, which is below them
+				return beta;
+		}
+
+		// The best action from an earlier search of this node is searched first
+		// Actions are generated lazily, so after a cutoff the rest never are
+		float maxLoss = depth <= LOSS_PRUNING_DEPTH ? LOSS_MARGIN * (depth - 1) : INFINITY;
+		Game::initActions(statep, hashAction, maxLoss, ply);
+
+		float alphaOrig = alpha;
+		float value = -INFINITY;
+		uint16_t bestKey = NO_ACTION;
+		unsigned int i = 0;
+		typename Game::Action const* actionp;
+		for (; alpha < beta && (actionp = Game::nextAction(ply)); i++) {
+			bool quiet = Game::isQuiet(statep, actionp);
+
+			Game::makeMove(*statep, actionp, ply);
+
+			// Principal variation search: the first action is expected to be
+			// the best, so the rest are only searched to prove they are worse
+			float childValue;
+			if (i == 0) {
+				childValue = -negamax<Game>(statep, depth - 1, -beta, -alpha, ply + 1);
+			} else {
+				// Late move reductions: actions ordered late are unlikely to
+				// be best, so quiet ones are searched shallower first
+				unsigned int reduction = 0;
+				if (depth >= LMR_MIN_DEPTH && i >= LMR_MIN_INDEX && quiet)
+					reduction = 1 + (depth >= LMR_DEEP_DEPTH && i >= LMR_DEEP_INDEX);
 
-Evaluation bestAction(Gamestate const* statep, unsigned int depth);
-float negamax(Gamestate const* statep, unsigned int depth, float alpha, float beta);
+				childValue = -negamax<Game>(statep, depth - 1 - reduction, -nullWindow(alpha), -alpha, ply + 1);
+				if (reduction != 0 && childValue > alpha)
+					// Failed high, it must be searched to full depth
+					childValue = -negamax<Game>(statep, depth - 1, -nullWindow(alpha), -alpha, ply + 1);
+				if (childValue > alpha && childValue < beta)
+					// Better than the principal variation, get its exact value
+					childValue = -negamax<Game>(statep, depth - 1, -beta, -alpha, ply + 1);
+			}
+
+			Game::unmakeMove(*statep, actionp, ply);
+
+			if (childValue > value) {
+				value = childValue;
+				bestKey = Game::actionKey(actionp);
+			}
+			alpha = std::max(alpha, value);
+
+			if (alpha >= beta && quiet && !stopSearch.load(std::memory_order_relaxed))
+				updateOrdering(Game::actionKey(actionp), depth, ply);
+		}
+
+		if (i == 0)
+			// No actions, the game is over
+			return leafValue<Game>(statep, depth);
+
+		if (!stopSearch.load(std::memory_order_relaxed)) {
+			Bound bound = Bound::EXACT;
+			if (value <= alphaOrig) {
+				// All children failed low, so none of them is known to be best
+				bound = Bound::UPPER;
+				bestKey = NO_ACTION;
+			} else if (value >= beta) {
+				bound = Bound::LOWER;
+			}
+			tt.store(key, {value, depth, bound, bestKey});
+		}
+
+		return value;
+	}
+
+	template <typename Game>
+	float searchRoot(const std::vector<typename Game::State*>& states, const std::vector<unsigned int>& order, unsigned int depth, float alpha, float beta, unsigned int& bestIndex)
+	{
+		// Principal variation search of the children of the root in the given order
+		float value = -INFINITY;
+		for (unsigned int n=0; n<order.size() && alpha < beta; n++) {
+			unsigned int i = order[n];
+			float childValue;
+			if (n == 0) {
+				childValue = -negamax<Game>(states[i], depth - 1, -beta, -alpha, 1);
+			} else {
+				childValue = -negamax<Game>(states[i], depth - 1, -nullWindow(alpha), -alpha, 1);
+				if (childValue > alpha && childValue < beta)
+					// Better than the principal variation, get its exact value
+					childValue = -negamax<Game>(states[i], depth - 1, -beta, -alpha, 1);
+			}
+			if (stopSearch.load(std::memory_order_relaxed))
+				break;
+			if (childValue > value) {
+				// New best action
+				value = childValue;
+				bestIndex = i;
+			}
+			alpha = std::max(alpha, value);
+		}
+
+		totalNodes += nodes;
+		nodes = 0;
+
+		return value;
+	}
+
+	struct Iteration
+	{
+		unsigned int bestIndex;
+		float value;
+		unsigned int depth;
+	};
+
+	template <typename Game>
+	Iteration iterativeDeepening(const std::vector<typename Game::State*>& states, unsigned int maxDepth, unsigned int thread)
+	{
+		// Search the root to increasing depths until maxDepth is completed or
+		// the search is stopped, and return the last completed iteration
+		// `thread` is the index of the search thread, the main thread is 0
+		bool isMain = thread == 0;
+		enforceLimits = false;
+		resetOrdering();
+
+		// Search the children of the root starting at child `thread`
+		std::vector<unsigned int> order(states.size());
+		for (unsigned int i=0; i<states.size(); i++)
+			order[i] = (i + thread) % states.size();
+
+		Iteration result {order[0], -INFINITY, 0};
+
+		for (unsigned int depth=1; depth<=maxDepth; depth++) {
+			if (skipDepth(thread, depth))
+				continue;
+
+			unsigned int bestIndex = order[0];
+
+			// Aspiration window: expect the value to be close to that of the
+			// previous iteration, and widen the window when it is not
+			float delta = ASPIRATION_WINDOW;
+			float alpha = -INFINITY;
+			float beta = INFINITY;
+			if (result.depth != 0 && std::abs(result.value) < WIN_VALUE) {
+				alpha = result.value - delta;
+				beta = result.value + delta;
+			}
+
+			float value;
+			while (true) {
+				value = searchRoot<Game>(states, order, depth, alpha, beta, bestIndex);
+				if (stopSearch.load(std::memory_order_relaxed))
+					break;
+
+				if (value <= alpha) {
+					delta *= 2;
+					alpha = value - delta;
+				} else if (value >= beta) {
+					delta *= 2;
+					beta = value + delta;
+				} else {
+					break;
+				}
+
+				if (delta >= WIN_VALUE) {
+					alpha = -INFINITY;
+					beta = INFINITY;
+				}
+			}
+
+			if (stopSearch.load(std::memory_order_relaxed))
+				// The iteration was aborted, so its result is incomplete
+				break;
+
+			result = {bestIndex, value, depth};
+
+			// Search the principal variation first in the next iteration
+			// Below the root it is found through the actions in the transposition table
+			auto it = std::find(order.begin(), order.end(), bestIndex);
+			std::rotate(order.begin(), it, it + 1);
+
+			if (!isMain)
+				continue;
+
+			enforceLimits = true;
+
+			if (searchLimits.time.count() != 0 && 2 * elapsed() >= searchLimits.time)
+				// The next iteration would most likely not complete in time
+				break;
+		}
+
+		return result;
+	}
+}
+
+template <typename Game>
+Evaluation<Game> bestAction(typename Game::State const* statep, const SearchLimits& limits)
+{
+	using namespace search;
+
+	// State must not be terminal
+	std::vector<typename Game::State*> states;
+	std::vector<typename Game::Action*> actions;
+
+	// Generate children of root node
+	Game::genChildren(statep, states, actions);
+
+	if (states.empty())
+		throw std::runtime_error("Terminal state given to bestAction");
+
+	searchLimits = limits;
+	searchStart = std::chrono::steady_clock::now();
+	stopSearch = false;
+	totalNodes = 0;
+	tt.newSearch();
+
+	unsigned int maxDepth = limits.depth != 0 ? std::min(limits.depth, MAX_DEPTH) : MAX_DEPTH;
+
+	// Lazy SMP: helper threads search the same root independently and share
+	// their results through the transposition table. Each helper skips some
+	// depths, see skipDepth, and starts at a different root move, so the
+	// threads don't all search the same subtree at the same time.
+	// Only the result of the main thread is used.
+	// The children of the root are played on in place, so each helper
+	// generates its own.
+	std::vector<std::thread> helpers;
+	for (unsigned int i=1; i<searchThreads; i++) {
+		helpers.emplace_back([statep, maxDepth, i]() {
+			std::vector<typename Game::State*> helperStates;
+			std::vector<typename Game::Action*> helperActions;
+			Game::genChildren(statep, helperStates, helperActions);
+
+			iterativeDeepening<Game>(helperStates, maxDepth, i);
+
+			for (unsigned int n=0; n<helperStates.size(); n++) {
+				Game::deleteAction(helperActions[n]);
+				Game::deleteState(helperStates[n]);
+			}
+		});
+	}
+
+	Iteration result = iterativeDeepening<Game>(states, maxDepth, 0);
+
+	stopSearch = true;
+	for (std::thread& helper : helpers)
+		helper.join();
+
+	for (unsigned int i=0; i<states.size(); i++) {
+		if (i != result.bestIndex)
+			Game::deleteAction(actions[i]);
+		Game::deleteState(states[i]);
+	}
+
+	return { actions[result.bestIndex], result.value, result.depth };
+}
+
+template <typename Game>
+Evaluation<Game> bestAction(typename Game::State const* statep, unsigned int depth)
+{
+	SearchLimits limits;
+	limits.depth = depth;
+	return bestAction<Game>(statep, limits);
+}
 
 #endif
@@ -0,0 +1,154 @@
+#include "tt.h"
+
+#include <cstring>
+#include <climits>
+
+namespace
+{
+	constexpr unsigned int GENERATION_MASK = 0x3f;
+
+	// Entry layout: value:32 | depth:8 | bound:2 | generation:6 | action:16
+	uint64_t pack(const TTEntry& entry, uint8_t generation)
+	{
+		uint32_t valueBits;
+		std::memcpy(&valueBits, &entry.value, sizeof(valueBits));
+
+		return static_cast<uint64_t>(valueBits) |
+			static_cast<uint64_t>(entry.depth & 0xff) << 32 |
+			static_cast<uint64_t>(entry.bound) << 40 |
+			static_cast<uint64_t>(generation & GENERATION_MASK) << 42 |
+			static_cast<uint64_t>(entry.action) << 48;
+	}
+
+	TTEntry unpack(uint64_t data)
+	{
+		TTEntry entry;
+		uint32_t valueBits = static_cast<uint32_t>(data);
+		std::memcpy(&entry.value, &valueBits, sizeof(valueBits));
+		entry.depth = (data >> 32) & 0xff;
+		entry.bound = static_cast<Bound>((data >> 40) & 0x3);
+		entry.action = static_cast<uint16_t>(data >> 48);
+		return entry;
+	}
+
+	unsigned int depthOf(uint64_t data)
+	{
+		return (data >> 32) & 0xff;
+	}
+
+	uint8_t generationOf(uint64_t data)
+	{
+		return (data >> 42) & GENERATION_MASK;
+	}
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+	: generation{0}
+{
+	resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+	size_t amtBuckets = (megabytes << 20) / sizeof(Bucket);
+
+	indexBits = 0;
+	while ((size_t{2} << indexBits) <= amtBuckets)
+		indexBits++;
+
+	buckets.reset(new Bucket[size_t{1} << indexBits]);
+	clear();
+}
+
+void TranspositionTable::clear()
+{
+	for (size_t i=0; i < (size_t{1} << indexBits); i++) {
+		for (Slot& slot : buckets[i].slots) {
+			// An empty slot has depth 0, and is never returned by probe
+			slot.data.store(0, std::memory_order_relaxed);
+			slot.check.store(0, std::memory_order_relaxed);
+		}
+	}
+	generation = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+	generation = (generation + 1) & GENERATION_MASK;
+}
+
+TranspositionTable::Bucket& TranspositionTable::bucket(uint64_t key) const
+{
+	// Fibonacci hashing, so keys with poorly distributed low bits still spread out
+	if (indexBits == 0)
+		return buckets[0];
+	return buckets[(key * 0x9e3779b97f4a7c15) >> (64 - indexBits)];
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const
+{
+	for (const Slot& slot : bucket(key).slots) {
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+		if ((check ^ data) == key && depthOf(data) != 0) {
+			entry = unpack(data);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TranspositionTable::store(uint64_t key, const TTEntry& entry)
+{
+	// Replacement policy, in order of preference:
+	// 	The slot already holding this key, unless it holds a deeper result from
+	// 	this search and the new result is not exact
+	// 	An empty slot
+	// 	The slot with the lowest depth, where each search of age counts as 8 plies
+	Bucket& b = bucket(key);
+	Slot* target = nullptr;
+	int lowestQuality = INT_MAX;
+	uint16_t action = entry.action;
+
+	for (Slot& slot : b.slots) {
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+		if ((check ^ data) == key && depthOf(data) != 0) {
+			if (
+				entry.bound != Bound::EXACT &&
+				generationOf(data) == generation &&
+				depthOf(data) > (entry.depth & 0xff)
+			)
+				return;
+
+			if (action == NO_ACTION)
+				// Keep the best action from the earlier search of this node
+				action = unpack(data).action;
+
+			target = &slot;
+			break;
+		}
+
+		if (depthOf(data) == 0) {
+			target = &slot;
+			lowestQuality = INT_MIN;
+			continue;
+		}
+
+		int age = (generation - generationOf(data)) & GENERATION_MASK;
+		int quality = static_cast<int>(depthOf(data)) - 8 * age;
+		if (quality < lowestQuality) {
+			target = &slot;
+			lowestQuality = quality;
+		}
+	}
+
+	TTEntry stored = entry;
+	stored.action = action;
+	uint64_t data = pack(stored, generation);
+	target->data.store(data, std::memory_order_relaxed);
+	target->check.store(key ^ data, std::memory_order_relaxed);
+}
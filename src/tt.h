@@ -0,0 +1,65 @@
+#ifndef TT_H_INCLUDED
+#define TT_H_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "game.h"
+
+enum class Bound : uint8_t
+{
+	EXACT,
+	LOWER, /* The node failed high, the true value is >= value */
+	UPPER  /* The node failed low, the true value is <= value */
+};
+
+struct TTEntry
+{
+	float value;
+	unsigned int depth; /* Stored modulo 256 */
+	Bound bound;
+	uint16_t action; /* Key of the best action, see actionKey in game.h */
+};
+
+class TranspositionTable
+{
+	// Lockless hashing: each slot stores `key ^ data` next to `data`.
+	// A slot that is torn by two threads writing at the same time fails the
+	// key check on probe, so no locking is needed between search threads.
+	struct Slot
+	{
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;
+	};
+
+	static constexpr unsigned int BUCKET_SIZE = 4;
+
+	// One bucket fills a cache line, so a probe costs a single memory access
+	struct alignas(64) Bucket
+	{
+		Slot slots[BUCKET_SIZE];
+	};
+
+	std::unique_ptr<Bucket[]> buckets;
+	unsigned int indexBits;
+
+	// Incremented for every search, used to replace entries from old searches first
+	uint8_t generation;
+
+	Bucket& bucket(uint64_t key) const;
+
+public:
+	TranspositionTable(size_t megabytes=16);
+
+	// Size is rounded down to a power of two buckets
+	void resize(size_t megabytes);
+	void clear();
+	void newSearch();
+
+	bool probe(uint64_t key, TTEntry& entry) const;
+	void store(uint64_t key, const TTEntry& entry);
+};
+
+#endif